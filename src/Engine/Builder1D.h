@@ -26,16 +26,30 @@ class Builder1D : public BuilderBase {
 
 	static const SizeType DIMENSION = 1;
 
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+
 public:
 
 	typedef TensorSrep::VectorPairSizeType VectorPairSizeType;
 	typedef TensorSrep::PairSizeType PairSizeType;
 
-	Builder1D(SizeType sites, SizeType arity, bool isPeriodic)
+	Builder1D(SizeType sites, SizeType arity, bool isPeriodic, bool isModifiedBinary = false)
 	    : sites_(sites), srep_("")
 	{
+		if (isModifiedBinary) {
+			if (arity != 2)
+				throw PsimagLite::RuntimeError("MeraBuilder1D: modified binary needs arity 2\n");
+			buildModifiedBinary();
+			return;
+		}
+
+		if (arity == 3) {
+			buildTernary(isPeriodic);
+			return;
+		}
+
 		if (arity != 2)
-			throw PsimagLite::RuntimeError("MeraBuilder1D: arity must be 2 for now\n");
+			throw PsimagLite::RuntimeError("MeraBuilder1D: arity must be 2 or 3\n");
 
 		SizeType ln = 0;
 		if ((ln = ProgramGlobals::logBase2Strict(sites)) == 0)
@@ -82,6 +96,92 @@ public:
 
 private:
 
+	// modified binary: w's as in the binary MERA, but u acts only on every
+	// other pair between w's, sites 4i + 1 and 4i + 2 of each layer.
+	// No u crosses the border, so the srep is the same for periodic
+	void buildModifiedBinary()
+	{
+		if (ProgramGlobals::logBase2Strict(sites_) < 2)
+			throw PsimagLite::RuntimeError("MeraBuilder: sites must be 2^n with n > 1\n");
+
+		VectorStringType legs(sites_, "");
+		for (SizeType i = 0; i < sites_; ++i)
+			legs[i] = "f" + ttos(i);
+
+		SizeType summed = 0;
+		SizeType idsU = 0;
+		SizeType idsW = 0;
+		while (legs.size() > 2) {
+			SizeType n = legs.size()/4;
+			for (SizeType i = 0; i < n; ++i) {
+				PsimagLite::String o0 = "s" + ttos(summed++);
+				PsimagLite::String o1 = "s" + ttos(summed++);
+				srep_ += "u" + ttos(idsU++) + "(" + legs[4*i + 1] + "," + legs[4*i + 2];
+				srep_ += "|" + o0 + "," + o1 + ")";
+				legs[4*i + 1] = o0;
+				legs[4*i + 2] = o1;
+			}
+
+			for (SizeType i = 0; i < 2*n; ++i) {
+				PsimagLite::String o0 = "s" + ttos(summed++);
+				srep_ += "w" + ttos(idsW++) + "(" + legs[2*i] + "," + legs[2*i + 1];
+				srep_ += "|" + o0 + ")";
+				legs[i] = o0;
+			}
+
+			legs.resize(2*n);
+		}
+
+		srep_ += "r0(" + legs[0] + "," + legs[1] + ")";
+	}
+
+	// u acts on the two sites between consecutive blocks of three,
+	// w maps a block of three into one site of the next layer
+	void buildTernary(bool isPeriodic)
+	{
+		if (ProgramGlobals::logBaseStrict(sites_, 3) < 2)
+			throw PsimagLite::RuntimeError("MeraBuilder: sites must be 3^n with n > 1\n");
+
+		VectorStringType legs(sites_, "");
+		for (SizeType i = 0; i < sites_; ++i)
+			legs[i] = "f" + ttos(i);
+
+		SizeType summed = 0;
+		SizeType idsU = 0;
+		SizeType idsW = 0;
+		while (legs.size() > 3) {
+			SizeType n = legs.size()/3;
+			SizeType us = (isPeriodic) ? n : n - 1;
+			VectorStringType left(n, "");
+			VectorStringType right(n, "");
+			for (SizeType i = 0; i < n; ++i) {
+				left[i] = legs[3*i];
+				right[i] = legs[3*i + 2];
+			}
+
+			for (SizeType i = 0; i < us; ++i) {
+				SizeType j = (i + 1 == n) ? 0 : i + 1;
+				PsimagLite::String o0 = "s" + ttos(summed++);
+				PsimagLite::String o1 = "s" + ttos(summed++);
+				srep_ += "u" + ttos(idsU++) + "(" + legs[3*i + 2] + "," + legs[3*j];
+				srep_ += "|" + o0 + "," + o1 + ")";
+				right[i] = o0;
+				left[j] = o1;
+			}
+
+			for (SizeType i = 0; i < n; ++i) {
+				PsimagLite::String o0 = "s" + ttos(summed++);
+				srep_ += "w" + ttos(idsW++) + "(" + left[i] + "," + legs[3*i + 1];
+				srep_ += "," + right[i] + "|" + o0 + ")";
+				legs[i] = o0;
+			}
+
+			legs.resize(n);
+		}
+
+		srep_ += "r0(" + legs[0] + "," + legs[1] + "," + legs[2] + ")";
+	}
+
 	SizeType createUlayer(SizeType& summed,
 	                      SizeType& idsU,
 	                      SizeType savedSummed,
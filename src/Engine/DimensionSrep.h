@@ -11,15 +11,15 @@ class DimensionSrep {
 	typedef TensorSrep TensorSrepType;
 	typedef TensorSrepType::TensorStanzaType TensorStanzaType;
 	typedef TensorSrepType::VectorSizeType VectorSizeType;
+	typedef typename SymmetryLocalType::PairStringSizeType PairStringSizeType;
 
 public:
 
-	typedef typename SymmetryLocalType::VectorVectorSizeType VectorVectorSizeType;
-
 	DimensionSrep(PsimagLite::String srep,
 	              SymmetryLocalType& symmLocal,
-	              SizeType m)
-	    : m_(m),dsrep_(srep),symmLocal_(symmLocal)
+	              SizeType m,
+	              const SymmetryLocalType* previous = 0)
+	    : m_(m),dsrep_(srep),symmLocal_(symmLocal),previous_(previous)
 	{
 		dStoSymm(symmLocal_.qOne().size());
 		alterFrees(symmLocal_.qOne().size());
@@ -43,7 +43,7 @@ private:
 			if (ts.type() == TensorStanzaType::TENSOR_TYPE_ERASED)
 				continue;
 
-			symmLocal_.setNameId(i, ts.name() + ttos(ts.id()));
+			symmLocal_.setNameId(i, PairStringSizeType(ts.name(), ts.id()));
 
 			SizeType legs = ts.legs();
 			for (SizeType j = 0; j < legs; ++j) {
@@ -68,14 +68,14 @@ private:
 
 			SizeType ins = ts.ins();
 			VectorSizeType dim(ins,0);
-			VectorVectorSizeType q(ins,0);
+			VectorSizeType q(ins,0);
 			SizeType counter = 0;
 
 			for (SizeType j = 0; j < ins; ++j) {
 				TensorStanzaType::IndexTypeEnum t = ts.legType(j);
 				if (t != TensorStanzaType::INDEX_TYPE_DIM) continue;
 				dim[j] = ts.legTag(j);
-				q[j] = symmLocal_.q(i,j);
+				q[j] = symmLocal_.handle(i,j);
 
 				counter++;
 			}
@@ -91,7 +91,7 @@ private:
 				SizeType s = dsrep_.legTag(i,j + ins);
 				if (outs == 1) {
 					dsrep_.legTag(i,j + ins) = prodDim;
-					symmLocal_.setQ(i,j + ins, q, dim, m_);
+					symmLocal_.setQ(i,j + ins, q, dim, m_, previous_);
 				} else if (outs == dim.size()) {
 					dsrep_.legTag(i,j + ins) = dim[j];
 					symmLocal_.setQ(i,j + ins, q[j]);
@@ -99,14 +99,14 @@ private:
 					throw PsimagLite::RuntimeError("DimensionSrep: outs > ins not supported\n");
 				}
 
-				replaceSummed(s,dsrep_.legTag(i,j + ins), symmLocal_.q(i,j + ins));
+				replaceSummed(s,dsrep_.legTag(i,j + ins), symmLocal_.handle(i,j + ins));
 			}
 		}
 
 		dsrep_.refresh();
 	}
 
-	void replaceSummed(SizeType s, SizeType val, VectorSizeType* q)
+	void replaceSummed(SizeType s, SizeType val, SizeType q)
 	{
 		for (SizeType i = 0; i < dsrep_.size(); ++i) {
 			TensorStanzaType ts = dsrep_(i);
@@ -145,6 +145,7 @@ private:
 	SizeType m_;
 	TensorSrepType dsrep_;
 	SymmetryLocalType& symmLocal_;
+	const SymmetryLocalType* previous_;
 }; //
 
 } // namespace  Mera
@@ -43,7 +43,9 @@ public:
 		knownLabels += " TensorId Layer IgnoreTerm Environ Terms";
 		knownLabels += " Total NoSymmetryLocal FirstOfLayer Tolerance Model MeraOptions";
 		knownLabels += " Sites Shift MERA IsMeraPeriodic DsrepEnvirons hamiltonianConnection";
-		knownLabels += " qOne";
+		knownLabels += " qOne MSchedule ScaleInvariant IterFixedPoint ReflectionMap MirrorTerms";
+		knownLabels += " PolarMethod TruncationPolicy CorrelationsSite SweepConnections";
+		knownLabels += " ProfileFile TraceFile";
 		PsimagLite::split(knownLabels_, knownLabels, " ");
 	}
 
@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_LOCAL_OBSERVABLES_H
+#define MERA_LOCAL_OBSERVABLES_H
+#include "Vector.h"
+#include "Matrix.h"
+#include "TensorSrep.h"
+#include "Tensor.h"
+
+namespace Mera {
+
+/* Two-site reduced density matrices x of the sites of the energy terms,
+ * and one-site ones as their partial traces, with <O> = sum O(ab,cd)
+ * x(a,b,c,d) as for the energy; x(f0,f1|f2,f3) has the bra legs of the
+ * two sites first, as the environment of h in its term would have them.
+ * PairDensityMatrices computes them.
+ */
+template<typename ComplexOrRealType>
+class LocalObservables {
+
+public:
+
+	typedef Tensor<ComplexOrRealType> TensorType;
+	typedef typename TensorType::MatrixType MatrixType;
+	typedef typename TensorType::VectorSizeType VectorSizeType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef std::pair<SizeType, SizeType> PairSizeType;
+
+	// the frees of mera that the outs of the h of term ind, whose rhs is
+	// term, end on, and the id of that h
+	static void sitesOfTerm(PairSizeType& sites,
+	                        SizeType& hId,
+	                        const TensorSrep& term,
+	                        const TensorSrep& mera,
+	                        SizeType ind)
+	{
+		SizeType ntensors = term.size();
+		SizeType h = ntensors;
+		for (SizeType i = 0; i < ntensors; ++i) {
+			if (term(i).name() != "h") continue;
+			if (h < ntensors || term(i).legs() != 4)
+				throw PsimagLite::RuntimeError("Observables: term " + ttos(ind) +
+				                               " needs one two-site h\n");
+			h = i;
+		}
+
+		if (h == ntensors)
+			throw PsimagLite::RuntimeError("Observables: no h in term " + ttos(ind) + "\n");
+
+		hId = term(h).id();
+		sites.first = siteOf(term, h, 2, mera, ind);
+		sites.second = siteOf(term, h, 3, mera, ind);
+	}
+
+	// o x o, as a two-site operator for twoSite()
+	static MatrixType product(const MatrixType& o)
+	{
+		SizeType d = o.n_row();
+		MatrixType m(d*d, d*d);
+		for (SizeType a = 0; a < d; ++a)
+			for (SizeType b = 0; b < d; ++b)
+				for (SizeType c = 0; c < d; ++c)
+					for (SizeType e = 0; e < d; ++e)
+						m(a + b*d, c + e*d) = o(a,c)*o(b,e);
+		return m;
+	}
+
+	static RealType trace(const TensorType& x)
+	{
+		SizeType d = x.argSize(0);
+		VectorSizeType args(4, 0);
+		RealType sum = 0.0;
+		for (SizeType a = 0; a < d; ++a) {
+			for (SizeType b = 0; b < d; ++b) {
+				args[0] = args[2] = a;
+				args[1] = args[3] = b;
+				sum += PsimagLite::real(x(args));
+			}
+		}
+
+		return sum;
+	}
+
+	// m(ab,cd) as in ModelBase::twoSiteHam()
+	static RealType twoSite(const TensorType& x, const MatrixType& m)
+	{
+		SizeType d2 = m.n_row();
+		assert(x.volume() == d2*d2);
+		RealType sum = 0.0;
+		for (SizeType i = 0; i < d2; ++i)
+			for (SizeType j = 0; j < d2; ++j)
+				sum += PsimagLite::real(m(i,j)*x.data()[i + j*d2]);
+		return sum;
+	}
+
+	// o on the site of leg 0 or leg 1 of h
+	static RealType oneSite(const TensorType& x, const MatrixType& o, SizeType leg)
+	{
+		assert(leg < 2);
+		SizeType d = o.n_row();
+		VectorSizeType args(4, 0);
+		RealType sum = 0.0;
+		for (SizeType a = 0; a < d; ++a) {
+			for (SizeType c = 0; c < d; ++c) {
+				if (o(a,c) == 0.0) continue;
+				for (SizeType b = 0; b < d; ++b) {
+					args[leg] = a;
+					args[leg + 2] = c;
+					args[1 - leg] = args[3 - leg] = b;
+					sum += PsimagLite::real(o(a,c)*x(args));
+				}
+			}
+		}
+
+		return sum;
+	}
+
+private:
+
+	// the out leg j of h is summed with a leg of a tensor of the mera,
+	// which is free there
+	static SizeType siteOf(const TensorSrep& x,
+	                       SizeType h,
+	                       SizeType j,
+	                       const TensorSrep& mera,
+	                       SizeType ind)
+	{
+		SizeType tag = x(h).legTag(j);
+		for (SizeType i = 0; i < x.size(); ++i) {
+			if (i == h || x(i).isConjugate()) continue;
+			for (SizeType k = 0; k < x(i).legs(); ++k) {
+				if (x(i).legType(k) != TensorStanza::INDEX_TYPE_SUMMED) continue;
+				if (x(i).legTag(k) != tag) continue;
+				for (SizeType l = 0; l < mera.size(); ++l) {
+					if (mera(l).name() != x(i).name() || mera(l).id() != x(i).id())
+						continue;
+					if (mera(l).isConjugate() || k >= mera(l).legs()) continue;
+					if (mera(l).legType(k) == TensorStanza::INDEX_TYPE_FREE)
+						return mera(l).legTag(k);
+				}
+			}
+		}
+
+		throw PsimagLite::RuntimeError("Observables: h of term " + ttos(ind) +
+		                               " is not on sites of the MERA\n");
+	}
+}; // class LocalObservables
+} // namespace Mera
+#endif // MERA_LOCAL_OBSERVABLES_H
@@ -37,18 +37,20 @@ public:
 	            SizeType arity,
 	            SizeType dimension,
 	            bool isPeriodic,
-	            const VectorType& hamTerms)
+	            const VectorType& hamTerms,
+	            bool isModifiedBinary = false)
 	    : sites_(sites),
 	      arity_(arity),
 	      dimension_(dimension),
 	      isPeriodic_(isPeriodic),
+	      isModifiedBinary_(isModifiedBinary),
 	      srep_(""),
 	      energy_(sites*dimension,0)
 	{
 		BuilderBase* builder = 0;
 
 		if (dimension == 1) {
-			builder = new Builder1D(sites, arity, isPeriodic);
+			builder = new Builder1D(sites, arity, isPeriodic, isModifiedBinary);
 		} else if (dimension == 2) {
 			builder = new Builder2D(sites, arity, isPeriodic);
 		} else {
@@ -90,6 +92,8 @@ public:
 
 	bool isPeriodic() const { return isPeriodic_; }
 
+	bool isModifiedBinary() const { return isModifiedBinary_; }
+
 private:
 
 	void buildEnergies(const BuilderBase& builder,
@@ -111,6 +115,7 @@ private:
 	SizeType arity_;
 	SizeType dimension_;
 	bool isPeriodic_;
+	bool isModifiedBinary_;
 	PsimagLite::String srep_;
 	VectorTensorSrepType energy_;
 }; // class MeraBuilder
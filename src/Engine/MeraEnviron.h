@@ -21,6 +21,7 @@ along with MERA++. If not, see <http://www.gnu.org/licenses/>.
 #include "ParametersForMera.h"
 #include "TensorSrep.h"
 #include "MeraBuilder.h"
+#include "ReflectionMap.h"
 
 namespace Mera {
 
@@ -46,21 +47,26 @@ public:
 	      symmLocal_(symmLocal),
 	      tensorSrep_(builder()),
 	      envs_(""),
-	      dsrep_("")
+	      dsrep_(""),
+	      reflection_(0)
 	{
+		if (params_.options.find("Reflection") != PsimagLite::String::npos)
+			reflectionInit();
+
 		sizeOfRoot_ = findSizeOfRoot();
 		SizeType counterForOutput = 100;
-		VectorSizeType limits;
-		findLimits(limits);
-		for (SizeType i = 0; i < tensorSrep_.size(); ++i) {
-			counterForOutput += environForTensor(i,
-			                                     counterForOutput,
-			                                     limits);
-		}
+		for (SizeType i = 0; i < tensorSrep_.size(); ++i)
+			counterForOutput += environForTensor(i, counterForOutput);
 
 		energies();
 	}
 
+	~MeraEnviron()
+	{
+		delete reflection_;
+		reflection_ = 0;
+	}
+
 	const PsimagLite::String& environs() const
 	{
 		return envs_;
@@ -74,9 +80,7 @@ public:
 private:
 
 	// find Y (environment) for this tensor
-	SizeType environForTensor(SizeType ind,
-	                          SizeType counterForOutput,
-	                          const VectorSizeType& limits)
+	SizeType environForTensor(SizeType ind, SizeType counterForOutput)
 	{
 		SizeType id = tensorSrep_(ind).id();
 		PsimagLite::String name = tensorSrep_(ind).name();
@@ -84,10 +88,16 @@ private:
 		VectorStringType vstr(connections,"");
 		VectorStringType argForOutput(connections,"");
 		VectorStringType vdsrep(connections,"");
+		VectorSizeType mirrorTerms(connections, 0);
 		SizeType terms = 0;
 
+		if (reflection_ && (*reflection_)(ind) < ind)
+			return terms; // follows its mirror
+
 		for (SizeType c = 0; c < connections; ++c) {
 			if (params_.hamiltonianConnection[c] == 0.0) continue;
+			if (reflection_ && isMirrorOfEarlierTerm(ind, c, mirrorTerms))
+				continue;
 			TensorSrep tmp = environForTensorOneSite(ind, c);
 			vstr[c] = tmp.sRep();
 			argForOutput[c] = calcArgForOutput(vdsrep[c],tmp);
@@ -99,9 +109,19 @@ private:
 		PsimagLite::String thisEnv("TensorId=" + name + "," + ttos(id) + "\n");
 		thisEnv += "Terms=" + ttos(terms) + "\n";
 		thisEnv += "IgnoreTerm=" + ttos(2*connections+1) + "\n";
-		PairSizeType layer = findLayerNumber(name, id, limits);
+		PairSizeType layer = findLayerNumber(name, id);
 		thisEnv += "Layer=" + ttos(layer.first) + "\n";
 		thisEnv += "FirstOfLayer=" + ttos(layer.second) + "\n";
+		if (reflection_) {
+			PsimagLite::String flags("");
+			for (SizeType c = 0; c < connections; ++c) {
+				if (vstr[c] == "") continue;
+				flags += ((flags == "") ? "" : ",") + ttos(mirrorTerms[c]);
+			}
+
+			thisEnv += "MirrorTerms=" + flags + "\n";
+		}
+
 		bool isRootTensor = (tensorSrep_(ind).name() == "r");
 		for (SizeType c = 0; c < connections; ++c) {
 			if (vstr[c] == "") continue;
@@ -118,6 +138,41 @@ private:
 		return terms;
 	}
 
+	/* For a tensor that is its own mirror, the term of bond c is the
+	 * reflection of the term of the mirror bond. Only the first of the two
+	 * is computed, with MirrorTerms 1, and ParallelEnvironHelper adds it
+	 * again with its legs reversed. The root is left alone.
+	 */
+	bool isMirrorOfEarlierTerm(SizeType ind, SizeType c, VectorSizeType& mirrorTerms) const
+	{
+		if ((*reflection_)(ind) != ind || tensorSrep_(ind).name() == "r")
+			return false;
+
+		SizeType mc = reflection_->bond(c);
+		if (mc < c) return true;
+		if (mc > c) mirrorTerms[c] = 1;
+		return false;
+	}
+
+	void reflectionInit()
+	{
+		reflection_ = new ReflectionMap(tensorSrep_);
+
+		SizeType connections = params_.hamiltonianConnection.size();
+		for (SizeType c = 0; c < connections; ++c) {
+			SizeType mc = reflection_->bond(c);
+			if (params_.hamiltonianConnection[c] == params_.hamiltonianConnection[mc])
+				continue;
+			PsimagLite::String str("Reflection: hamiltonianConnection " + ttos(c));
+			throw PsimagLite::RuntimeError(str + " differs from its mirror\n");
+		}
+
+		envs_ += "ReflectionMap " + ttos(reflection_->size()) + "\n";
+		for (SizeType i = 0; i < reflection_->size(); ++i)
+			envs_ += ttos((*reflection_)(i)) + "\n";
+		envs_ += "\n";
+	}
+
 	TensorSrep environForTensorOneSite(SizeType ind,
 	                                   SizeType site) const
 	{
@@ -251,10 +306,31 @@ private:
 		if (sizeOfRoot_ % sizeWithoutIrrIdentity != 0)
 			throw PsimagLite::RuntimeError("irreducibleIdentityDsrep\n");
 
+		// legs of the root are all of the same size
 		SizeType tmp = sizeOfRoot_/sizeWithoutIrrIdentity;
+		SizeType legs = frees.size();
+		SizeType dim = legSize(tmp, legs);
+		PsimagLite::String d("");
+		for (SizeType i = 0; i < legs; ++i)
+			d += ((i == 0) ? "D" : ",D") + ttos(dim);
+
 		SizeType id = rightSrep(indexOfIdentity).id();
-		dsrep_ += "i" + ttos(id) + "(D" + ttos(tmp) + "|D" + ttos(tmp) + ")";
-		symmLocal_.addIdentity(id, tmp);
+		dsrep_ += "i" + ttos(id) + "(" + d + "|" + d + ")";
+		symmLocal_.addIdentity(id, dim, legs);
+	}
+
+	static SizeType legSize(SizeType total, SizeType legs)
+	{
+		if (legs == 1) return total;
+		for (SizeType dim = 1; dim <= total; ++dim) {
+			SizeType prod = 1;
+			for (SizeType i = 0; i < legs; ++i)
+				prod *= dim;
+			if (prod == total) return dim;
+			if (prod > total) break;
+		}
+
+		throw PsimagLite::RuntimeError("irreducibleIdentityDsrep: legs of different sizes\n");
 
 	}
 
@@ -331,39 +407,48 @@ private:
 		dsrep_ += d;
 	}
 
-	PairSizeType findLayerNumber(PsimagLite::String name,
-	                         SizeType id,
-	                         const VectorSizeType& limits) const
+	PairSizeType findLayerNumber(PsimagLite::String name, SizeType id) const
 	{
 		if (name != "w" && name != "u")
 			return PairSizeType(0,1); // FIXME: think about layer number for other tensors
 
+		VectorSizeType limits;
+		findLimits(limits, name);
 		SizeType n = limits.size();
+		// even and odd w's of the modified binary MERA have their legs
+		// mirrored, (site,u) and (u,site), so each copies the first of its kind
+		bool twoKinds = (builder_.isModifiedBinary() && name == "w");
 		for (SizeType i = 0; i < n; ++i) {
 			SizeType firstOfLayer = (i > 0) ? limits[i-1] : 0;
-			if (id < limits[i]) return PairSizeType(i,firstOfLayer);
+			if (id >= limits[i]) continue;
+			if (twoKinds && ((id - firstOfLayer) & 1))
+				++firstOfLayer;
+			return PairSizeType(i,firstOfLayer);
 		}
 
 		throw PsimagLite::RuntimeError("findLayerNumber: not found\n");
 	}
 
-	void findLimits(VectorSizeType& limits) const
+	// a layer has sites/arity w's, and as many u's except for an
+	// open ternary MERA, where there is no u between the borders,
+	// and for the modified binary MERA, which has half of them
+	void findLimits(VectorSizeType& limits, PsimagLite::String name) const
 	{
 		SizeType arity = builder_.arity();
 		SizeType sites = builder_.sites();
 
-		if (arity != 2) {
-			PsimagLite::RuntimeError("findLimits: supported only for arity=2\n");
-		}
-
-		limits.push_back(sites/arity);
-		SizeType tmp = sites/arity;
-		SizeType i = 1;
+		if (arity < 2)
+			throw PsimagLite::RuntimeError("findLimits: arity must be at least 2\n");
 
-		while (tmp > 1) {
-			limits.push_back(limits[i-1] + tmp/arity);
-			tmp /= arity;
-			++i;
+		bool lessUs = (arity == 3 && name == "u" && !builder_.isPeriodic());
+		bool halfUs = (builder_.isModifiedBinary() && name == "u");
+		SizeType total = 0;
+		for (SizeType tmp = sites/arity; tmp > 0; tmp /= arity) {
+			if (halfUs)
+				total += tmp/2;
+			else
+				total += (lessUs) ? tmp - 1 : tmp;
+			limits.push_back(total);
 		}
 	}
 
@@ -380,6 +465,7 @@ private:
 	PsimagLite::String envs_;
 	PsimagLite::String dsrep_;
 	mutable IrreducibleIdentity irreducibleIdentity_;
+	ReflectionMap* reflection_;
 }; //class
 
 } //namespace
@@ -27,6 +27,9 @@ along with MERA++. If not, see <http://www.gnu.org/licenses/>.
 #include "ModelSelector.h"
 #include "ModelBase.h"
 #include "DimensionSrep.h"
+#include "SuperOperator.h"
+#include "LocalObservables.h"
+#include "PairDensityMatrices.h"
 
 namespace Mera {
 
@@ -36,10 +39,15 @@ class MeraSolver {
 	typedef PsimagLite::InputNg<InputCheck> InputNgType;
 	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef std::pair<SizeType, SizeType> PairSizeType;
+	typedef PsimagLite::Vector<PairSizeType>::Type VectorPairSizeType;
 	typedef TensorOptimizer<ComplexOrRealType,InputNgType::Readable> TensorOptimizerType;
 	typedef typename PsimagLite::Vector<TensorOptimizerType*>::Type VectorTensorOptimizerType;
 	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+	typedef PsimagLite::Vector<bool>::Type VectorBoolType;
 	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+	typedef typename PsimagLite::Vector<MatrixType>::Type VectorMatrixType;
+	typedef typename PsimagLite::Vector<ComplexOrRealType>::Type VectorType;
 	typedef typename TensorOptimizerType::MapPairStringSizeType MapPairStringSizeType;
 	typedef typename TensorOptimizerType::ParametersForSolverType ParametersForSolverType;
 	typedef typename TensorOptimizerType::SrepStatementType SrepStatementType;
@@ -52,7 +60,14 @@ class MeraSolver {
 	typedef ModelBase<ComplexOrRealType> ModelBaseType;
 	typedef ModelSelector<ModelBaseType> ModelType;
 	typedef typename TensorOptimizerType::SymmetryLocalType SymmetryLocalType;
+	typedef typename TensorOptimizerType::TensorPoolType TensorPoolType;
 	typedef typename TensorOptimizerType::ParametersForMeraType ParametersForMeraType;
+	typedef typename TensorOptimizerType::ParallelEnvironHelperType ParallelEnvironHelperType;
+	typedef typename PsimagLite::Vector<ParallelEnvironHelperType*>::Type
+	VectorParallelEnvironHelperType;
+	typedef SuperOperator<ComplexOrRealType,InputNgType::Readable> SuperOperatorType;
+	typedef typename PsimagLite::Vector<SuperOperatorType*>::Type VectorSuperOperatorType;
+	typedef PairDensityMatrices<ComplexOrRealType> PairDensityMatricesType;
 
 	static const int EVAL_BREAKUP = TensorOptimizerType::EVAL_BREAKUP;
 
@@ -63,16 +78,42 @@ public:
 	      symmLocal_(0),
 	      meraStr_(""),
 	      isMeraPeriodic_(false),
+	      isScaleInvariant_(false),
+	      transitional_(0),
+	      iterFixedPoint_(100),
 	      iterMera_(1),
 	      iterTensor_(1),
+	      correlationsSite_(-1),
+	      m_(paramsForMera_.m),
+	      noSymmLocal_(false),
 	      indexOfRootTensor_(0),
 	      model_(paramsForMera_.model, paramsForMera_.hamiltonianConnection),
-	      paramsForLanczos_(0)
+	      paramsForLanczos_(0),
+	      lastRevision_(0)
 	{
 		InputCheck inputCheck;
 		InputNgType::Writeable ioWriteable(filename,inputCheck);
 		InputNgType::Readable io(ioWriteable);
 
+		if (paramsForMera_.options.find("Profile") != PsimagLite::String::npos) {
+			PsimagLite::String profileFile = filename + ".json";
+			try {
+				io.readline(profileFile,"ProfileFile=");
+			} catch (std::exception&) {}
+
+			Profiler::enable(profileFile);
+		}
+
+		if (paramsForMera_.options.find("Trace") != PsimagLite::String::npos) {
+			PsimagLite::String traceFile = filename + ".trace.json";
+			try {
+				io.readline(traceFile,"TraceFile=");
+			} catch (std::exception&) {}
+
+			Profiler::enableTrace(traceFile,
+			                      PsimagLite::Concurrency::codeSectionParams.npthreads);
+		}
+
 		paramsForLanczos_ = new ParametersForSolverType(io,"Mera");
 
 		int x = 0;
@@ -87,14 +128,44 @@ public:
 			io.readline(iterTensor_,"IterTensor=");
 		} catch (std::exception&) {}
 
+		try {
+			io.read(mSchedule_,"MSchedule");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(transitional_,"ScaleInvariant=");
+			isScaleInvariant_ = true;
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(iterFixedPoint_,"IterFixedPoint=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(correlationsSite_,"CorrelationsSite=");
+		} catch (std::exception&) {}
+
+		try {
+			io.read(sweepConnections_,"SweepConnections");
+		} catch (std::exception&) {}
+
+		SizeType connections = paramsForMera_.hamiltonianConnection.size();
+		if (sweepConnections_.size() % connections != 0)
+			throw PsimagLite::RuntimeError("SweepConnections: not a multiple of " +
+			                               ttos(connections) + "\n");
+
+		if (isScaleInvariant_ && sweepConnections_.size() > 0)
+			throw PsimagLite::RuntimeError("ScaleInvariant does not support SweepConnections\n");
 
-		io.readline(meraStr_,"MERA=");
+		if (!isScaleInvariant_)
+			io.readline(meraStr_,"MERA=");
 		io.readline(dsrepEnvirons_, "DsrepEnvirons=");
 
 		PsimagLite::String hString = "D" + ttos(model_().qOne().size());
 		PsimagLite::String args = "(" + hString + "," + hString + "|";
 		args += hString + "," + hString + ")";
 		for (SizeType i = 0; i < paramsForMera_.hamiltonianConnection.size(); ++i) {
+			if (isScaleInvariant_) break;
 			if (paramsForMera_.hamiltonianConnection[i] == 0.0) continue;
 			meraStr_ += "h" + ttos(i) + args;
 		}
@@ -103,9 +174,15 @@ public:
 			io.readline(x,"NoSymmetryLocal=");
 		} catch (std::exception&) {}
 
-		bool noSymmLocal = (x == 0) ? false : true;
+		noSymmLocal_ = (x == 0) ? false : true;
 
-		updateTensorSizes(noSymmLocal);
+		if (isScaleInvariant_ && !noSymmLocal_)
+			throw PsimagLite::RuntimeError("ScaleInvariant needs NoSymmetryLocal=1\n");
+
+		if (isScaleInvariant_ && mSchedule_.size() > 0)
+			throw PsimagLite::RuntimeError("ScaleInvariant does not support MSchedule\n");
+
+		updateTensorSizes();
 
 		bool rootTensorFound = false;
 		while (true) {
@@ -131,6 +208,8 @@ public:
 				SizeType ignoreTerm = terms + 1;
 				io.readline(ignoreTerm,"IgnoreTerm=");
 				energyTerms_.resize(terms,0);
+				termEnergies_.resize(terms,0.0);
+				staleTerms_.resize(terms,true);
 
 				PsimagLite::String findStr = "Environ=";
 				for (SizeType i = 0; i < terms; ++i) {
@@ -147,10 +226,24 @@ public:
 				continue;
 			}
 
+			SizeType id = atoi(tokens[1].c_str());
+			if (name == "a" || name == "rho") {
+				SuperOperatorType* superOp = new SuperOperatorType(io,
+				                                                   name,
+				                                                   id,
+				                                                   tensorNameIds_,
+				                                                   nameIdsTensor_,
+				                                                   tensors_);
+				VectorSuperOperatorType& v = (name == "a") ? ascending_ : descending_;
+				if (superOp->layer() != v.size())
+					throw PsimagLite::RuntimeError("MeraSolver: layers out of order\n");
+				v.push_back(superOp);
+				continue;
+			}
+
 			if (name != "u" && name != "w" && name != "r")
 				continue;
 
-			SizeType id = atoi(tokens[1].c_str());
 			tensorOptimizer_.push_back(new TensorOptimizerType(io,
 			                                                   name,
 			                                                   id,
@@ -173,16 +266,37 @@ public:
 			}
 		}
 
-		if (!rootTensorFound) {
+		if (isScaleInvariant_ && (descending_.size() != transitional_ + 1 ||
+		                          ascending_.size() != transitional_ + 1)) {
+			PsimagLite::String msg("FATAL: File " + filename);
+			throw PsimagLite::RuntimeError(msg + " superoperators missing\n");
+		}
+
+		if (!rootTensorFound && !isScaleInvariant_) {
 			PsimagLite::String msg("FATAL: File " + filename);
 			throw PsimagLite::RuntimeError(msg + " root tensor not found\n");
 		}
 
+		// without a root to break the symmetry, the identity is stationary
+		// when w truncates, and the sweeps cannot leave it
+		if (isScaleInvariant_) {
+			for (SizeType i = 0; i < tensorOptimizer_.size(); ++i) {
+				const PairStringSizeType& nameId = tensorOptimizer_[i]->nameId();
+				tensor(nameId.first, nameId.second).setToRandomIsometry();
+			}
+		}
+
 		if (energyTerms_.size() == 0) {
 			PsimagLite::String msg("FATAL: File " + filename);
 			throw PsimagLite::RuntimeError(msg + " energyTerms not found\n");
 		}
 
+		if (paramsForMera_.options.find("LayerAverage") != PsimagLite::String::npos)
+			averageEnvironmentsOverLayers();
+
+		if (paramsForMera_.options.find("Reflection") != PsimagLite::String::npos)
+			reflectionInit(io);
+
 		std::cerr<<"MeraSolver::ctor() done\n";
 	}
 
@@ -203,18 +317,432 @@ public:
 			energyTerms_[i] = 0;
 		}
 
+		for (SizeType i = 0; i < ascending_.size(); ++i) {
+			delete ascending_[i];
+			ascending_[i] = 0;
+		}
+
+		for (SizeType i = 0; i < descending_.size(); ++i) {
+			delete descending_[i];
+			descending_[i] = 0;
+		}
+
 		delete paramsForLanczos_;
+		delete symmLocal_;
 	}
 
 	void optimize()
 	{
+		if (isScaleInvariant_)
+			return optimizeScaleInvariant();
+
 		RealType eprev = 1e6;
 		for (SizeType i = 0; i < iterMera_; ++i)
 			optimizeAllTensors(i, eprev);
+
+		for (SizeType j = 0; j < mSchedule_.size(); ++j) {
+			growBondDimension(mSchedule_[j]);
+			eprev = energy();
+			std::cout<<"energy after growing m to "<<m_<<"= "<<eprev<<"\n";
+			for (SizeType i = 0; i < iterMera_; ++i)
+				optimizeAllTensors(i, eprev);
+		}
+
+		printMeasurements();
+
+		SizeType connections = paramsForMera_.hamiltonianConnection.size();
+		SizeType points = sweepConnections_.size()/connections;
+		for (SizeType p = 0; p < points; ++p) {
+			setConnections(p);
+			eprev = energy();
+			std::cout<<"energy at sweep point "<<p<<"= "<<eprev<<"\n";
+			for (SizeType i = 0; i < iterMera_; ++i)
+				optimizeAllTensors(i, eprev);
+			printMeasurements();
+		}
 	}
 
 private:
 
+	// observables and correlations share the states of the sites, so that
+	// each is computed once
+	void printMeasurements()
+	{
+		bool observables = (paramsForMera_.options.find("Observables") !=
+		                    PsimagLite::String::npos);
+		bool correlations = (paramsForMera_.options.find("Correlations") !=
+		                     PsimagLite::String::npos);
+		if (!observables && !correlations) return;
+
+		TensorSrep all(meraStr_);
+		PsimagLite::String str;
+		for (SizeType i = 0; i < all.size(); ++i)
+			if (all(i).name() != "h") str += all(i).sRep();
+		TensorSrep mera(str);
+
+		PairDensityMatricesType pairs(mera,
+		                              paramsForMera_.evaluator,
+		                              tensorNameIds_,
+		                              nameIdsTensor_,
+		                              tensors_);
+
+		if (observables)
+			printLocalObservables(pairs, mera);
+
+		if (correlations)
+			printCorrelations(pairs, mera);
+	}
+
+	// Point p of SweepConnections: the model is rebuilt with its couplings
+	// and only the h tensors change, so that the networks, their plans
+	// and the converged tensors of the previous point are reused
+	void setConnections(SizeType p)
+	{
+		SizeType connections = paramsForMera_.hamiltonianConnection.size();
+		VectorType v(connections);
+		for (SizeType c = 0; c < connections; ++c) {
+			v[c] = sweepConnections_[p*connections + c];
+			bool wasZero = (paramsForMera_.hamiltonianConnection[c] == 0.0);
+			if ((v[c] == 0.0) == wasZero) continue;
+			PsimagLite::String str("SweepConnections: point " + ttos(p));
+			throw PsimagLite::RuntimeError(str + " changes which connections are zero\n");
+		}
+
+		std::cout<<"SweepPoint="<<p<<" hamiltonianConnection";
+		for (SizeType c = 0; c < connections; ++c)
+			std::cout<<" "<<v[c];
+		std::cout<<"\n";
+
+		model_.reset(v);
+		SizeType ntensors = tensors_.size();
+		for (SizeType i = 0; i < ntensors; ++i) {
+			if (tensorNameIds_[i].first != "h" || !tensors_[i]) continue;
+			tensors_[i]->setToMatrix(model_().twoSiteHam(tensorNameIds_[i].second));
+			tensorChanged(i);
+		}
+
+		TensorPoolType::clearSparseOperands();
+
+		if (mirrorFollower_.size() > 0)
+			checkReflectionOfH();
+	}
+
+	// Continuation in m: tensors converged with the current m are embedded
+	// into the larger ones, and isometries are completed with new columns
+	void growBondDimension(SizeType m)
+	{
+		if (m_ == 0 || m <= m_) {
+			PsimagLite::String str("MSchedule: m=" + ttos(m) + " after m=" + ttos(m_));
+			throw PsimagLite::RuntimeError(str + " is not an increase\n");
+		}
+
+		m_ = m;
+		VectorTensorType previous = tensors_;
+		updateTensorSizes();
+
+		SizeType noptimizers = tensorOptimizer_.size();
+		for (SizeType i = 0; i < noptimizers; ++i) {
+			tensorOptimizer_[i]->changeOfBondDimension(symmLocal_);
+
+			const PairStringSizeType& nameId = tensorOptimizer_[i]->nameId();
+			SizeType ind = nameIdsTensor_[nameId];
+			assert(ind < tensors_.size());
+			tensors_[ind]->embed(*previous[ind]);
+			if (nameId.first != "r")
+				completeIsometry(ind);
+			updateMirror(ind);
+		}
+
+		SizeType ntensors = tensors_.size();
+		for (SizeType i = 0; i < ntensors; ++i) {
+			if (previous[i] == tensors_[i]) continue;
+			delete previous[i];
+			previous[i] = 0;
+		}
+
+		tensorOptimizer_[indexOfRootTensor_]->resizeIrreducibleIdentities();
+	}
+
+	// with SymmetryLocal, the new outs of a u or w keep their charges
+	void completeIsometry(SizeType ind)
+	{
+		const PairStringSizeType& p = tensorNameIds_[ind];
+		SizeType tensorIndex = (symmLocal_) ? symmLocal_->tensorIndex(p) : 0;
+		if (!symmLocal_ || tensorIndex >= symmLocal_->size() ||
+		        (p.first != "u" && p.first != "w")) {
+			tensors_[ind]->completeIsometry();
+			return;
+		}
+
+		VectorSizeType sectorOfIn;
+		VectorSizeType sectorOfOut;
+		sectorsOf(sectorOfIn, sectorOfOut, *tensors_[ind], *symmLocal_, tensorIndex);
+		tensors_[ind]->completeIsometry(sectorOfIn, sectorOfOut);
+	}
+
+	// Each sweep descends rho from the fixed point of the repeated layer,
+	// then optimizes layers bottom up, ascending a after each update; an
+	// update that raises the energy of its layer is undone
+	void optimizeScaleInvariant()
+	{
+		RealType e = 0;
+		for (SizeType iter = 0; iter < iterMera_; ++iter) {
+			descendAll();
+			e = energy();
+			std::cout<<"energy per bond before sweep "<<iter<<"= "<<e;
+			std::cout<<" [ Remember shift="<<model_().energyShift()<<" ]\n";
+
+			SizeType noptimizers = tensorOptimizer_.size();
+			for (SizeType layer = 0; layer <= transitional_; ++layer) {
+				RealType eprev = layerEnergy(layer);
+				for (SizeType i = 0; i < noptimizers; ++i) {
+					if (tensorOptimizer_[i]->layer() != layer) continue;
+					VectorType saved;
+					if (layer == transitional_)
+						sumOverScales(saved);
+					tensorOptimizer_[i]->optimize(iterTensor_,
+					                              iter,
+					                              paramsForMera_.evaluator);
+					if (saved.size() > 0)
+						tensor("a", layer).data() = saved;
+					e = layerEnergy(layer);
+					if (e > eprev) {
+						std::cerr<<"MeraSolver: found larger energy ";
+						std::cerr<<e<<" restoring previous...\n";
+						tensorOptimizer_[i]->restoreTensor();
+						e = layerEnergy(layer);
+					}
+
+					eprev = e;
+					const PairStringSizeType& nameId = tensorOptimizer_[i]->nameId();
+					std::cout<<"energy of layer "<<layer<<" after optimizing ";
+					std::cout<<nameId.first<<nameId.second<<"= "<<e<<"\n";
+				}
+			}
+		}
+
+		descendAll();
+		e = energy();
+		std::cout<<"energy per bond= "<<e;
+		std::cout<<" [ Remember shift="<<model_().energyShift()<<" ]\n";
+	}
+
+	// Tr(rho a) above layer, a ascended through it with its current tensors;
+	// it is the energy per bond once rho is descended again. Above the
+	// repeated layer rho is its fixed point, which moves with its tensors
+	RealType layerEnergy(SizeType layer)
+	{
+		if (layer == transitional_)
+			fixedPoint();
+		ascending_[layer]->apply(paramsForMera_.evaluator);
+		const TensorType& rho = tensor("rho", layer + 1);
+		const TensorType& a = tensor("a", layer + 1);
+		SizeType dins = 1;
+		for (SizeType i = 0; i < rho.ins(); ++i)
+			dins *= rho.argSize(i);
+
+		ComplexOrRealType sum = 0.0;
+		for (SizeType x = 0; x < dins; ++x)
+			for (SizeType y = 0; y < dins; ++y)
+				sum += rho.data()[x + y*dins]*a.data()[y + x*dins];
+
+		return PsimagLite::real(sum);
+	}
+
+	/* The repeated layer is at every scale above transitional_, and each
+	 * scale has the energy per bond of the one below, so its environments
+	 * see the average of a ascended through it k = 0, 1, ... times, until
+	 * the ascent converges. a of the layer holds that average until the
+	 * update is done; its previous value is left in saved.
+	 */
+	void sumOverScales(VectorType& saved)
+	{
+		TensorType& a = tensor("a", transitional_);
+		const TensorType& above = ascending_[transitional_]->tensor();
+		if (a.data().size() != above.data().size()) return;
+
+		saved = a.data();
+		VectorType sum = saved;
+		SizeType scales = 1;
+		while (scales <= iterFixedPoint_) {
+			ascending_[transitional_]->apply(paramsForMera_.evaluator);
+			RealType diff = maxDifference(a, above);
+			a.data() = above.data();
+			for (SizeType x = 0; x < sum.size(); ++x)
+				sum[x] += above.data()[x];
+			++scales;
+			if (diff < paramsForMera_.tolerance) break;
+		}
+
+		for (SizeType x = 0; x < sum.size(); ++x)
+			sum[x] /= static_cast<RealType>(scales);
+		a.data() = sum;
+	}
+
+	// fixed point of the repeated layer, then rho of the others
+	void descendAll()
+	{
+		fixedPoint();
+		for (SizeType layer = transitional_; layer > 0; --layer)
+			descending_[layer - 1]->apply(paramsForMera_.evaluator);
+	}
+
+	// power iteration for rho of the repeated layer, started from the last one
+	void fixedPoint()
+	{
+		SuperOperatorType& top = *(descending_[transitional_]);
+		TensorType& rho = top.tensor();
+		TensorType& rhoAbove = tensor("rho", transitional_ + 1);
+		RealType diff = 0;
+		SizeType iter = 0;
+		for (; iter < iterFixedPoint_; ++iter) {
+			top.apply(paramsForMera_.evaluator);
+			normalizeTrace(rho);
+			diff = maxDifference(rho, rhoAbove);
+			rhoAbove.data() = rho.data();
+			if (diff < paramsForMera_.tolerance) break;
+		}
+
+		std::cerr<<"MeraSolver: fixed point after "<<iter<<" iterations, diff="<<diff<<"\n";
+	}
+
+	void normalizeTrace(TensorType& t) const
+	{
+		SizeType dins = 1;
+		for (SizeType i = 0; i < t.ins(); ++i)
+			dins *= t.argSize(i);
+
+		ComplexOrRealType sum = 0.0;
+		for (SizeType x = 0; x < dins; ++x)
+			sum += t.data()[x + x*dins];
+
+		if (PsimagLite::real(sum) == 0.0)
+			throw PsimagLite::RuntimeError("MeraSolver: rho has zero trace\n");
+
+		SizeType n = t.data().size();
+		for (SizeType i = 0; i < n; ++i)
+			t.data()[i] /= sum;
+	}
+
+	static RealType maxDifference(const TensorType& t1, const TensorType& t2)
+	{
+		SizeType n = t1.data().size();
+		assert(n == t2.data().size());
+		RealType max = 0;
+		for (SizeType i = 0; i < n; ++i) {
+			RealType tmp = std::abs(t1.data()[i] - t2.data()[i]);
+			if (tmp > max) max = tmp;
+		}
+
+		return max;
+	}
+
+	TensorType& tensor(PsimagLite::String name, SizeType id)
+	{
+		PairStringSizeType p(name, id);
+		SizeType ind = nameIdsTensor_[p];
+		if (ind >= tensors_.size() || tensorNameIds_[ind] != p)
+			throw PsimagLite::RuntimeError("MeraSolver: no tensor " + name + ttos(id) + "\n");
+		return *(tensors_[ind]);
+	}
+
+	// Only first tensors of layers are optimized under translation
+	// invariance; their environments become the sum over the layer
+	void averageEnvironmentsOverLayers()
+	{
+		bool optimizeAllLayers =
+		        (paramsForMera_.options.find("OptimizeAllLayers") != PsimagLite::String::npos);
+		if (!isMeraPeriodic_ || optimizeAllLayers || isScaleInvariant_) {
+			PsimagLite::String str("LayerAverage needs IsMeraPeriodic=1 and");
+			throw PsimagLite::RuntimeError(str + " one optimization per layer\n");
+		}
+
+		SizeType ntensors = tensorOptimizer_.size();
+		for (SizeType i = 0; i < ntensors; ++i) {
+			PsimagLite::String name = tensorOptimizer_[i]->nameId().first;
+			SizeType id = tensorOptimizer_[i]->nameId().second;
+			SizeType firstOfLayer = tensorOptimizer_[i]->firstOfLayer();
+			if (name == "r" || id == firstOfLayer) continue;
+
+			SizeType j = 0;
+			for (; j < ntensors; ++j) {
+				const PairStringSizeType& nameId = tensorOptimizer_[j]->nameId();
+				if (nameId.first == name && nameId.second == firstOfLayer) break;
+			}
+
+			if (j == ntensors) {
+				PsimagLite::String str("LayerAverage: no environment for ");
+				throw PsimagLite::RuntimeError(str + name + ttos(firstOfLayer) + "\n");
+			}
+
+			tensorOptimizer_[j]->moveEnvironmentsFrom(*tensorOptimizer_[i]);
+		}
+	}
+
+	/* Mirror-symmetric MERA. Of each pair of mirror tensors only the first
+	 * has environments, the second follows it with its legs reversed.
+	 * Tensors that are their own mirror have halved environments,
+	 * which needs h to be symmetric under reflection.
+	 * Copies of the first of a layer would overwrite the followers, so
+	 * a periodic MERA needs OptimizeAllLayers.
+	 */
+	void reflectionInit(InputNgType::Readable& io)
+	{
+		if (!noSymmLocal_ || isScaleInvariant_ ||
+		        paramsForMera_.options.find("LayerAverage") != PsimagLite::String::npos) {
+			PsimagLite::String str("Reflection needs NoSymmetryLocal=1");
+			throw PsimagLite::RuntimeError(str + " and no LayerAverage\n");
+		}
+
+		if (isMeraPeriodic_ &&
+		        paramsForMera_.options.find("OptimizeAllLayers") == PsimagLite::String::npos) {
+			PsimagLite::String str("Reflection needs IsMeraPeriodic=0");
+			throw PsimagLite::RuntimeError(str + " or OptimizeAllLayers\n");
+		}
+
+		VectorSizeType reflectionMap;
+		io.read(reflectionMap,"ReflectionMap");
+		TensorSrep tsrep(meraStr_);
+		SizeType ntensors = tensors_.size();
+		SizeType n = reflectionMap.size();
+		mirrorFollower_.resize(ntensors, ntensors);
+		for (SizeType i = 0; i < n; ++i) {
+			SizeType j = reflectionMap[i];
+			if (j >= tsrep.size() || i >= tsrep.size())
+				throw PsimagLite::RuntimeError("ReflectionMap: index too large\n");
+			if (j <= i) continue;
+			SizeType ind = nameIdsTensor_[PairStringSizeType(tsrep(i).name(), tsrep(i).id())];
+			SizeType jnd = nameIdsTensor_[PairStringSizeType(tsrep(j).name(), tsrep(j).id())];
+			mirrorFollower_[ind] = jnd;
+			updateMirror(ind);
+		}
+
+		checkReflectionOfH();
+	}
+
+	void checkReflectionOfH()
+	{
+		SizeType sites = paramsForMera_.hamiltonianConnection.size();
+		for (SizeType c = 0; c < sites; ++c) {
+			if (paramsForMera_.hamiltonianConnection[c] == 0.0) continue;
+			const TensorType& h = tensor("h", c);
+			TensorType mirror(h);
+			mirror.setToMirrorOf(tensor("h", (2*sites - 2 - c) % sites));
+			if (maxDifference(h, mirror) < 1e-10) continue;
+			PsimagLite::String str("Reflection: h" + ttos(c));
+			throw PsimagLite::RuntimeError(str + " is not symmetric under reflection\n");
+		}
+	}
+
+	void updateMirror(SizeType ind)
+	{
+		if (ind >= mirrorFollower_.size()) return;
+		SizeType jnd = mirrorFollower_[ind];
+		if (jnd >= tensors_.size()) return;
+		tensors_[jnd]->setToMirrorOf(*tensors_[ind]);
+		tensorChanged(jnd);
+	}
+
 	void optimizeAllTensors(SizeType iter, RealType& eprev)
 	{
 		static bool seenRoot = false;
@@ -223,6 +751,8 @@ private:
 		if (paramsForMera_.options.find("OptimizeAllLayers") != PsimagLite::String::npos)
 			optimizeOnlyFirstOfLayer = false;
 
+		bool layerJacobi = (paramsForMera_.options.find("LayerJacobi") != PsimagLite::String::npos);
+
 		SizeType ntensors = tensorOptimizer_.size();
 
 		for (SizeType i = 0; i < ntensors; ++i) {
@@ -231,8 +761,14 @@ private:
 			SizeType id = tensorOptimizer_[i]->nameId().second;
 
 			SizeType firstOfLayer = tensorOptimizer_[i]->firstOfLayer();
+			SizeType ind = nameIdsTensor_[tensorOptimizer_[i]->nameId()];
 			if (optimizeOnlyFirstOfLayer && firstOfLayer != id && name != "r") {
+				SizeType src = nameIdsTensor_[PairStringSizeType(name, firstOfLayer)];
+				if (isCopyOf(ind, src)) continue;
 				tensorOptimizer_[i]->copyFirstOfLayer(name, firstOfLayer);
+				tensorChanged(ind);
+				copiedRevision_[ind] = PairSizeType(revision_[src], revision_[ind]);
+				updateMirror(ind);
 				continue;
 			}
 
@@ -243,16 +779,35 @@ private:
 					seenRoot = true;
 			}
 
+			SizeType end = (layerJacobi) ? endOfLayer(i, optimizeOnlyFirstOfLayer) : i + 1;
+			if (end > i + 1) {
+				optimizeLayer(i, end, iter, eprev);
+				i = end - 1;
+				continue;
+			}
+
+			VectorRealType termEnergies = termEnergies_;
+			VectorBoolType staleTerms = staleTerms_;
+			SizeType revision = revision_[ind];
 			tensorOptimizer_[i]->optimize(iterTensor_,
 			                              iter,
 			                              paramsForMera_.evaluator);
+			tensorChanged(ind);
+			updateMirror(ind);
 
-			RealType e = energy();
+			double t0 = Profiler::now();
+			RealType e = energyAfterUpdate(i);
+			if (Profiler::enabled())
+				Profiler::addPhase(name + ttos(id), "energy", t0);
 			if (e > eprev) {
 				std::cerr<<"MeraSolver: found larger energy ";
 				std::cerr<<e<<" restoring previous...\n";
 				tensorOptimizer_[i]->restoreTensor();
-				e = energy();
+				revision_[ind] = revision;
+				updateMirror(ind);
+				termEnergies_ = termEnergies;
+				staleTerms_ = staleTerms;
+				e = energyOfStaleTerms();
 			}
 
 			eprev = e;
@@ -263,94 +818,447 @@ private:
 		}
 	}
 
+	/* Energy after optimizer i updated its tensor. Only the terms that
+	 * hold a changed tensor are contracted again, the others keep their
+	 * values; for the root that is all terms. MeraOptions=FullEnergy
+	 * checks against all terms, and for the root also r^H Y r of its
+	 * environment, which is the energy only if Y is that of the network.
+	 */
+	RealType energyAfterUpdate(SizeType i)
+	{
+		RealType e = validatedEnergy(energyOfStaleTerms());
+		if (paramsForMera_.options.find("FullEnergy") == PsimagLite::String::npos)
+			return e;
+
+		RealType ryr = 0.0;
+		if (!tensorOptimizer_[i]->energyFromEnvironment(ryr)) return e;
+		if (fabs(ryr - e) > 1e-8*(1.0 + fabs(e)))
+			std::cerr<<"MeraSolver: r^H Y r= "<<ryr<<" but all terms give "<<e<<"\n";
+		return e;
+	}
+
+	RealType validatedEnergy(RealType e)
+	{
+		if (paramsForMera_.options.find("FullEnergy") == PsimagLite::String::npos)
+			return e;
+
+		RealType full = energy();
+		if (fabs(full - e) > 1e-8*(1.0 + fabs(full)))
+			std::cerr<<"MeraSolver: energy "<<e<<" but all terms give "<<full<<"\n";
+		return full;
+	}
+
+	// optimizers after i with the same name and layer, if optimized
+	SizeType endOfLayer(SizeType i, bool optimizeOnlyFirstOfLayer) const
+	{
+		const PairStringSizeType& nameId = tensorOptimizer_[i]->nameId();
+		SizeType layer = tensorOptimizer_[i]->layer();
+		SizeType j = i + 1;
+		if (nameId.first == "r") return j;
+
+		for (; j < tensorOptimizer_.size(); ++j) {
+			const PairStringSizeType& other = tensorOptimizer_[j]->nameId();
+			if (other.first != nameId.first || tensorOptimizer_[j]->layer() != layer)
+				break;
+			if (optimizeOnlyFirstOfLayer && tensorOptimizer_[j]->firstOfLayer() != other.second)
+				break;
+		}
+
+		return j;
+	}
+
+	/* MeraOptions=LayerJacobi updates optimizers start to end - 1 at once:
+	 * their environments are computed together from the same tensors,
+	 * a task per term, and only then are the tensors updated.
+	 * If the energy goes up all of them are restored.
+	 */
+	void optimizeLayer(SizeType start, SizeType end, SizeType iter, RealType& eprev)
+	{
+		typedef PsimagLite::Parallelizer<ParallelLayerHelper> ParallelizerType;
+
+		VectorRealType termEnergies = termEnergies_;
+		VectorBoolType staleTerms = staleTerms_;
+		VectorSizeType revisions(end - start, 0);
+		for (SizeType i = start; i < end; ++i) {
+			tensorOptimizer_[i]->saveTensor();
+			revisions[i - start] = revision_[nameIdsTensor_[tensorOptimizer_[i]->nameId()]];
+		}
+
+		const PairStringSizeType& first = tensorOptimizer_[start]->nameId();
+		const PairStringSizeType& last = tensorOptimizer_[end - 1]->nameId();
+		PsimagLite::String layer = first.first + ttos(first.second) + "-";
+		layer += last.first + ttos(last.second);
+		for (SizeType j = 0; j < iterTensor_; ++j) {
+			double t0 = Profiler::now();
+			ParallelizerType threadedEnviron(PsimagLite::Concurrency::codeSectionParams);
+			ParallelLayerHelper helper(tensorOptimizer_, start, end, paramsForMera_.evaluator);
+			threadedEnviron.loopCreate(helper);
+			double t1 = Profiler::now();
+			helper.sync();
+			if (Profiler::tracing())
+				Profiler::addEvent(Profiler::mainThread(), "reduction", layer, t1);
+			if (Profiler::enabled())
+				Profiler::addPhase(layer, "environ", t0);
+
+			for (SizeType i = start; i < end; ++i) {
+				MatrixType m = helper.matrix(i - start);
+				if (m.n_row() == 0) continue;
+				t0 = Profiler::now();
+				tensorOptimizer_[i]->update(iter, m);
+				if (!Profiler::enabled()) continue;
+				const PairStringSizeType& nameId = tensorOptimizer_[i]->nameId();
+				Profiler::addPhase(nameId.first + ttos(nameId.second),
+				                   tensorOptimizer_[i]->updatePhase(),
+				                   t0);
+			}
+
+			for (SizeType i = start; i < end; ++i) {
+				SizeType ind = nameIdsTensor_[tensorOptimizer_[i]->nameId()];
+				tensorChanged(ind);
+				updateMirror(ind);
+			}
+		}
+
+		double t0 = Profiler::now();
+		RealType e = validatedEnergy(energyOfStaleTerms());
+		if (Profiler::enabled())
+			Profiler::addPhase(layer, "energy", t0);
+		if (e > eprev) {
+			std::cerr<<"MeraSolver: found larger energy ";
+			std::cerr<<e<<" restoring previous...\n";
+			for (SizeType i = start; i < end; ++i) {
+				SizeType ind = nameIdsTensor_[tensorOptimizer_[i]->nameId()];
+				tensorOptimizer_[i]->restoreTensor();
+				revision_[ind] = revisions[i - start];
+				updateMirror(ind);
+			}
+
+			termEnergies_ = termEnergies;
+			staleTerms_ = staleTerms;
+			e = energyOfStaleTerms();
+		}
+
+		eprev = e;
+		PsimagLite::String str("energy after optimizing ");
+		str += layer + "= ";
+		std::cout<<str<<e<<" [ Remember shift=";
+		std::cout<<model_().energyShift()<<" ]\n";
+	}
+
+	class ParallelLayerHelper {
+
+	public:
+
+		ParallelLayerHelper(VectorTensorOptimizerType& tensorOptimizer,
+		                    SizeType start,
+		                    SizeType end,
+		                    PsimagLite::String evaluator)
+		    : helpers_(end - start, 0),
+		      offsets_(end - start + 1, 0)
+		{
+			for (SizeType k = 0; k < helpers_.size(); ++k) {
+				helpers_[k] = tensorOptimizer[start + k]->environHelper(evaluator);
+				offsets_[k + 1] = offsets_[k] + helpers_[k]->tasks();
+			}
+		}
+
+		~ParallelLayerHelper()
+		{
+			for (SizeType k = 0; k < helpers_.size(); ++k) {
+				delete helpers_[k];
+				helpers_[k] = 0;
+			}
+		}
+
+		// task numbers run over the terms of all optimizers
+		void doTask(SizeType taskNumber, SizeType threadNum)
+		{
+			SizeType k = std::upper_bound(offsets_.begin(), offsets_.end(), taskNumber) -
+			        offsets_.begin() - 1;
+			assert(k < helpers_.size());
+			helpers_[k]->doTask(taskNumber - offsets_[k], threadNum);
+		}
+
+		SizeType tasks() const { return offsets_[helpers_.size()]; }
+
+		void sync()
+		{
+			for (SizeType k = 0; k < helpers_.size(); ++k)
+				helpers_[k]->sync();
+		}
+
+		const MatrixType& matrix(SizeType k) const
+		{
+			assert(k < helpers_.size());
+			return helpers_[k]->matrix();
+		}
+
+	private:
+
+		ParallelLayerHelper(const ParallelLayerHelper&);
+
+		ParallelLayerHelper& operator=(const ParallelLayerHelper&);
+
+		VectorParallelEnvironHelperType helpers_;
+		VectorSizeType offsets_;
+	}; // class ParallelLayerHelper
+
+	void tensorChanged(SizeType ind)
+	{
+		assert(ind < tensorNameIds_.size() && ind < revision_.size());
+		revision_[ind] = ++lastRevision_;
+		const PairStringSizeType& nameId = tensorNameIds_[ind];
+		for (SizeType j = 0; j < energyTerms_.size(); ++j) {
+			if (staleTerms_[j] || !energyTerms_[j]) continue;
+			staleTerms_[j] = termHasTensor(*energyTerms_[j], nameId);
+		}
+	}
+
+	static bool termHasTensor(const SrepStatementType& term, const PairStringSizeType& nameId)
+	{
+		const TensorSrep& rhs = term.rhs();
+		for (SizeType j = 0; j < rhs.size(); ++j)
+			if (rhs(j).name() == nameId.first && rhs(j).id() == nameId.second)
+				return true;
+		return false;
+	}
+
 	class ParallelEnergyHelper {
 
 	public:
 
 		ParallelEnergyHelper(SymmetryLocalType* symmLocal,
 		                     VectorSrepStatementType& energyTerms,
+		                     const VectorSizeType& terms,
 		                     const VectorPairStringSizeType& tensorNameAndIds,
 		                     MapPairStringSizeType& nameIdsTensor,
 		                     VectorTensorType& tensors,
-		                     const ParametersForMeraType& paramsForMera)
+		                     const ParametersForMeraType& paramsForMera,
+		                     VectorRealType& termEnergies)
 		    : symmLocal_(symmLocal),
 		      energyTerms_(energyTerms),
+		      terms_(terms),
 		      tensorNameIds_(tensorNameAndIds),
 		      nameIdsTensor_(nameIdsTensor),
 		      tensors_(tensors),
 		      paramsForMera_(paramsForMera),
-		      e_(PsimagLite::Concurrency::codeSectionParams.npthreads, 0.0)
-		{}
-
-		void doTask(SizeType taskNumber, SizeType threadNum)
+		      termEnergies_(termEnergies)
 		{
-			assert(threadNum < e_.size());
-			e_[threadNum] += energy(taskNumber);
+			TensorPoolType::init(PsimagLite::Concurrency::codeSectionParams.npthreads);
 		}
 
-		SizeType tasks() const { return energyTerms_.size(); }
-
-		void sync()
+		// each task writes only its own term
+		void doTask(SizeType taskNumber, SizeType threadNum)
 		{
-			if (e_.size() == 0) return;
-			for (SizeType i = 1; i < e_.size(); ++i)
-				e_[0] += e_[i];
+			assert(taskNumber < terms_.size());
+			SizeType ind = terms_[taskNumber];
+			assert(ind < termEnergies_.size());
+			double t0 = Profiler::now();
+			termEnergies_[ind] = energy(ind, threadNum);
+			if (Profiler::tracing())
+				Profiler::addEvent(threadNum, "energy", "term " + ttos(ind), t0);
 		}
 
-		RealType energy() const
-		{
-			if (e_.size() == 0)
-				throw PsimagLite::RuntimeError("ParallelEnergyHelper failed\n");
-			return e_[0];
-		}
+		SizeType tasks() const { return terms_.size(); }
 
 	private:
 
-		RealType energy(SizeType ind)
+		RealType energy(SizeType ind, SizeType threadNum)
 		{
 			assert(ind < energyTerms_.size());
 			SrepStatementType* ptr = energyTerms_[ind];
 			if (!ptr) return 0.0;
+			VectorSizeType args(1,0);
+			TensorType out(1, 0);
 			TensorEvalBaseType* tensorEval =
 			        TensorOptimizerType::getTensorEvalPtr(paramsForMera_.evaluator,
 			                                              *ptr,
 			                                              tensors_,
 			                                              tensorNameIds_,
 			                                              nameIdsTensor_,
-			                                              symmLocal_);
+			                                              symmLocal_,
+			                                              TensorPoolType::ofThread(threadNum),
+			                                              &out);
 
 			typename TensorEvalBaseType::HandleType handle = tensorEval->operator()();
 			while (!handle.done());
 			delete tensorEval;
 			tensorEval = 0;
-			VectorSizeType args(1,0);
-			return tensors_[nameIdsTensor_[PairStringSizeType("e",ind)]]->operator()(args);
+			return out(args);
 		}
 
 		SymmetryLocalType* symmLocal_;
 		VectorSrepStatementType& energyTerms_;
+		const VectorSizeType& terms_;
 		const VectorPairStringSizeType& tensorNameIds_;
 		MapPairStringSizeType& nameIdsTensor_;
 		VectorTensorType& tensors_;
 		const ParametersForMeraType& paramsForMera_;
-		VectorRealType e_;
+		VectorRealType& termEnergies_;
 	}; // class ParallelEnergyHelper
 
+	// contracts all terms
 	RealType energy()
 	{
+		staleTerms_.assign(energyTerms_.size(), true);
+		return energyOfStaleTerms();
+	}
+
+	RealType energyOfStaleTerms()
+	{
+		VectorSizeType terms;
+		for (SizeType j = 0; j < energyTerms_.size(); ++j)
+			if (staleTerms_[j]) terms.push_back(j);
+
+		energyOfTerms(terms);
+
+		RealType sum = 0.0;
+		for (SizeType j = 0; j < energyTerms_.size(); ++j)
+			sum += termEnergies_[j];
+		return sum;
+	}
+
+	RealType energyOfTerms(const VectorSizeType& terms)
+	{
+		if (terms.size() == 0) return 0.0;
+
 		typedef PsimagLite::Parallelizer<ParallelEnergyHelper> ParallelizerType;
 		ParallelizerType threadedEnergies(PsimagLite::Concurrency::codeSectionParams);
 
 		ParallelEnergyHelper parallelEnergyHelper(symmLocal_,
 		                                          energyTerms_,
+		                                          terms,
 		                                          tensorNameIds_,
-	                                              nameIdsTensor_,
+		                                          nameIdsTensor_,
 		                                          tensors_,
-		                                          paramsForMera_);
+		                                          paramsForMera_,
+		                                          termEnergies_);
 
 		threadedEnergies.loopCreate(parallelEnergyHelper);
-		parallelEnergyHelper.sync();
-		return parallelEnergyHelper.energy();
+
+		RealType sum = 0.0;
+		for (SizeType j = 0; j < terms.size(); ++j) {
+			sum += termEnergies_[terms[j]];
+			staleTerms_[terms[j]] = false;
+		}
+
+		return sum;
+	}
+
+	// one line per term with its bond energy, then one per site with the
+	// observables of the model, from the density matrix of the first term
+	// on that site; mera is that of pairs
+	void printLocalObservables(PairDensityMatricesType& pairs, const TensorSrep& mera)
+	{
+		typedef LocalObservables<ComplexOrRealType> LocalObservablesType;
+		typedef typename LocalObservablesType::PairSizeType PairSizeType;
+
+		const ModelBaseType& model = model_();
+		SizeType nobs = model.observableNames().size();
+		VectorSizeType termOfSite;
+		VectorSizeType legOfSite;
+		VectorTensorType xs(energyTerms_.size(), 0);
+
+		std::cout<<"#LocalObservables bonds site0 site1 h energy trace\n";
+		for (SizeType i = 0; i < energyTerms_.size(); ++i) {
+			if (!energyTerms_[i]) continue;
+			PairSizeType sites;
+			SizeType hId = 0;
+			LocalObservablesType::sitesOfTerm(sites, hId, energyTerms_[i]->rhs(), mera, i);
+			xs[i] = new TensorType(1, 2);
+			pairs(*xs[i], sites.first, sites.second);
+
+			RealType tr = LocalObservablesType::trace(*xs[i]);
+			RealType e = LocalObservablesType::twoSite(*xs[i], model.twoSiteHam(hId));
+			if (tr != 0.0) e /= tr;
+			std::cout<<sites.first<<" "<<sites.second<<" "<<hId<<" "<<e<<" "<<tr<<"\n";
+
+			SizeType maxSite = std::max(sites.first, sites.second);
+			if (termOfSite.size() <= maxSite) {
+				termOfSite.resize(maxSite + 1, energyTerms_.size());
+				legOfSite.resize(maxSite + 1, 0);
+			}
+
+			if (termOfSite[sites.first] == energyTerms_.size()) {
+				termOfSite[sites.first] = i;
+				legOfSite[sites.first] = 0;
+			}
+
+			if (termOfSite[sites.second] == energyTerms_.size()) {
+				termOfSite[sites.second] = i;
+				legOfSite[sites.second] = 1;
+			}
+		}
+
+		std::cout<<"#LocalObservables sites site";
+		for (SizeType k = 0; k < nobs; ++k)
+			std::cout<<" "<<model.observableNames()[k];
+		std::cout<<"\n";
+		for (SizeType site = 0; site < termOfSite.size(); ++site) {
+			SizeType i = termOfSite[site];
+			if (i == energyTerms_.size()) continue;
+			RealType tr = LocalObservablesType::trace(*xs[i]);
+			RealType factor = (tr != 0.0) ? 1.0/tr : 1.0;
+			std::cout<<site;
+			for (SizeType k = 0; k < nobs; ++k) {
+				const MatrixType& o = model.observable(k);
+				std::cout<<" "<<factor*LocalObservablesType::oneSite(*xs[i], o, legOfSite[site]);
+			}
+
+			std::cout<<"\n";
+		}
+
+		for (SizeType i = 0; i < xs.size(); ++i) {
+			delete xs[i];
+			xs[i] = 0;
+		}
+	}
+
+	// <o_i o_j> and <o_i o_j> - <o_i><o_j> for the observables of the
+	// model, for all pairs i < j, or for the pairs of CorrelationsSite=;
+	// mera is that of pairs
+	void printCorrelations(PairDensityMatricesType& pairs, const TensorSrep& mera)
+	{
+		typedef LocalObservables<ComplexOrRealType> LocalObservablesType;
+
+		const ModelBaseType& model = model_();
+		SizeType nobs = model.observableNames().size();
+		VectorMatrixType products(nobs);
+		for (SizeType k = 0; k < nobs; ++k)
+			products[k] = LocalObservablesType::product(model.observable(k));
+
+		SizeType sites = mera.maxTag('f') + 1;
+		std::cout<<"#Correlations site0 site1";
+		for (SizeType k = 0; k < nobs; ++k) {
+			const PsimagLite::String& name = model.observableNames()[k];
+			std::cout<<" "<<name<<name<<" connected";
+		}
+
+		std::cout<<"\n";
+		for (SizeType i = 0; i < sites; ++i) {
+			if (correlationsSite_ >= 0 && i != static_cast<SizeType>(correlationsSite_))
+				continue;
+			SizeType start = (correlationsSite_ >= 0) ? 0 : i + 1;
+			for (SizeType j = start; j < sites; ++j) {
+				if (j == i) continue;
+				TensorType x(1, 2);
+				pairs(x, i, j);
+				RealType tr = LocalObservablesType::trace(x);
+				RealType factor = (tr != 0.0) ? 1.0/tr : 1.0;
+				std::cout<<i<<" "<<j;
+				for (SizeType k = 0; k < nobs; ++k) {
+					const MatrixType& o = model.observable(k);
+					RealType oo = factor*LocalObservablesType::twoSite(x, products[k]);
+					RealType oi = factor*LocalObservablesType::oneSite(x, o, 0);
+					RealType oj = factor*LocalObservablesType::oneSite(x, o, 1);
+					std::cout<<" "<<oo<<" "<<(oo - oi*oj);
+				}
+
+				std::cout<<"\n";
+			}
+		}
+
+		std::cout<<"#CorrelationsStates "<<pairs.states()<<" reused "<<pairs.reused()<<"\n";
 	}
 
 	void initTensorNameIds()
@@ -377,6 +1285,7 @@ private:
 			throw PsimagLite::RuntimeError(str);
 		}
 
+		TensorPoolType::clearSparseOperands();
 		for (SizeType i = 0; i < ntensors; ++i) {
 			PsimagLite::String name = td(i).name();
 			SizeType id = td(i).id();
@@ -404,12 +1313,39 @@ private:
 			tensors_[ind] = new TensorType(dimensions,ins);
 			if (name == "h") {
 				tensors_[ind]->setToMatrix(model_().twoSiteHam(id));
+			} else if (name == "a" && id == 0) {
+				tensors_[ind]->setToMatrix(threeSiteHam());
+			} else if (name == "rho") {
+				SizeType dins = 1;
+				for (SizeType j = 0; j < ins; ++j)
+					dins *= dimensions[j];
+				tensors_[ind]->setToIdentity(1.0/dins);
 			} else {
 				tensors_[ind]->setToIdentity(1.0);
 			}
 		}
 	}
 
+	// (h x 1 + 1 x h)/2, so that each bond is counted once per position
+	MatrixType threeSiteHam()
+	{
+		const MatrixType& h = model_().twoSiteHam(0);
+		SizeType d2 = h.n_row();
+		SizeType d = model_().qOne().size();
+		assert(d*d == d2);
+		MatrixType m(d2*d, d2*d);
+		for (SizeType i = 0; i < d2; ++i) {
+			for (SizeType j = 0; j < d2; ++j) {
+				for (SizeType k = 0; k < d; ++k) {
+					m(i + k*d2, j + k*d2) += 0.5*h(i,j);
+					m(k + i*d, k + j*d) += 0.5*h(i,j);
+				}
+			}
+		}
+
+		return m;
+	}
+
 	void findTensors(const TensorSrep& t)
 	{
 		SizeType ntensors = t.size();
@@ -435,18 +1371,30 @@ private:
 		}
 	}
 
-	void updateTensorSizes(bool noSymmLocal)
+	void updateTensorSizes()
 	{
+		if (isScaleInvariant_) {
+			TensorSrep tdstr(dsrepEnvirons_);
+			if (tensorNameIds_.size() == 0) {
+				findTensors(tdstr);
+				initTensorNameIds();
+			}
+
+			initTensors(tdstr);
+			return;
+		}
+
 		TensorSrep tsrep(meraStr_);
 		SizeType maxLegs = 2.0*paramsForMera_.hamiltonianConnection.size();
-		SymmetryLocal* symmLocal = new SymmetryLocal(tsrep.size(), model_().qOne(), maxLegs);
-		DimensionSrep<SymmetryLocal> dimSrep(meraStr_, *symmLocal, paramsForMera_.m);
+		SymmetryLocal* symmLocal = new SymmetryLocal(tsrep.size(),
+		                                             model_().qOne(),
+		                                             maxLegs,
+		                                             paramsForMera_.truncationPolicy);
+		DimensionSrep<SymmetryLocal> dimSrep(meraStr_, *symmLocal, m_, symmLocal_);
 		PsimagLite::String dsrep = dimSrep() + dsrepEnvirons_;
 
 		delete symmLocal_;
-		symmLocal_ = 0;
-		if (!noSymmLocal)
-			symmLocal_ = symmLocal;
+		symmLocal_ = (noSymmLocal_) ? 0 : symmLocal;
 
 		TensorSrep tdstr(dsrep);
 		if (tensorNameIds_.size() == 0) {
@@ -455,6 +1403,82 @@ private:
 		}
 
 		initTensors(tdstr);
+		initIsometries(*symmLocal);
+		if (noSymmLocal_)
+			delete symmLocal;
+
+		resetRevisions();
+	}
+
+	// the identity is no isometry of a truncated bond, whose kept states
+	// are sorted by charge; instead, the k-th out state of charge Q gets the
+	// k-th in state of charge Q, so that with or without SymmetryLocal the
+	// run starts from the same charge conserving u and w
+	void initIsometries(const SymmetryLocal& symm)
+	{
+		SizeType ntensors = tensors_.size();
+		for (SizeType i = 0; i < ntensors; ++i) {
+			const PairStringSizeType& p = tensorNameIds_[i];
+			if (p.first != "u" && p.first != "w") continue;
+			SizeType tensorIndex = symm.tensorIndex(p);
+			if (tensorIndex >= symm.size()) continue;
+			initIsometry(*tensors_[i], symm, tensorIndex);
+		}
+	}
+
+	static void initIsometry(TensorType& t, const SymmetryLocal& symm, SizeType tensorIndex)
+	{
+		VectorSizeType sectorOfIn;
+		VectorSizeType sectorOfOut;
+		sectorsOf(sectorOfIn, sectorOfOut, t, symm, tensorIndex);
+		SizeType dins = sectorOfIn.size();
+		SizeType douts = sectorOfOut.size();
+		PsimagLite::Vector<bool>::Type used(dins, false);
+
+		t.setToConstant(0.0);
+		for (SizeType y = 0; y < douts; ++y) {
+			SizeType x = 0;
+			for (; x < dins; ++x)
+				if (!used[x] && sectorOfIn[x] == sectorOfOut[y]) break;
+
+			if (x == dins)
+				throw PsimagLite::RuntimeError("initIsometry: no in state for an out state\n");
+
+			used[x] = true;
+			t.data()[x + y*dins] = 1.0;
+		}
+	}
+
+	static void sectorsOf(VectorSizeType& sectorOfIn,
+	                      VectorSizeType& sectorOfOut,
+	                      const TensorType& t,
+	                      const SymmetryLocal& symm,
+	                      SizeType tensorIndex)
+	{
+		SizeType legs = t.args();
+		VectorSizeType dimensions(legs, 0);
+		for (SizeType j = 0; j < legs; ++j)
+			dimensions[j] = t.dimension(j);
+
+		symm.sectorsOf(sectorOfIn, sectorOfOut, tensorIndex, dimensions, t.ins());
+	}
+
+	// every write to a tensor gives it a new revision, restoring it gives it
+	// back its old one; periodic copies are redone only if the revision of
+	// their source, or their own, moved since the last copy
+	void resetRevisions()
+	{
+		SizeType ntensors = tensors_.size();
+		revision_.resize(ntensors);
+		for (SizeType i = 0; i < ntensors; ++i)
+			revision_[i] = ++lastRevision_;
+		copiedRevision_.assign(ntensors, PairSizeType(0, 0));
+	}
+
+	bool isCopyOf(SizeType ind, SizeType src) const
+	{
+		assert(ind < copiedRevision_.size() && src < revision_.size());
+		return (copiedRevision_[ind] == PairSizeType(revision_[src], revision_[ind]));
 	}
 
 	MeraSolver(const MeraSolver&);
@@ -466,8 +1490,17 @@ private:
 	PsimagLite::String meraStr_;
 	PsimagLite::String dsrepEnvirons_;
 	bool isMeraPeriodic_;
+	bool isScaleInvariant_;
+	SizeType transitional_;
+	SizeType iterFixedPoint_;
 	SizeType iterMera_;
 	SizeType iterTensor_;
+	int correlationsSite_;
+	SizeType m_;
+	bool noSymmLocal_;
+	VectorSizeType mSchedule_;
+	VectorType sweepConnections_;
+	VectorSizeType mirrorFollower_;
 	SizeType indexOfRootTensor_;
 	VectorPairStringSizeType tensorNameIds_;
 	MapPairStringSizeType nameIdsTensor_;
@@ -476,6 +1509,13 @@ private:
 	VectorTensorOptimizerType tensorOptimizer_;
 	ParametersForSolverType* paramsForLanczos_;
 	VectorSrepStatementType energyTerms_;
+	VectorRealType termEnergies_;
+	VectorBoolType staleTerms_;
+	SizeType lastRevision_;
+	VectorSizeType revision_;
+	VectorPairSizeType copiedRevision_;
+	VectorSuperOperatorType ascending_;
+	VectorSuperOperatorType descending_;
 }; // class MeraSolver
 } // namespace Mera
 #endif // MERASOLVER_H
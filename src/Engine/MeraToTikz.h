@@ -36,8 +36,10 @@ class MeraToTikz {
 
 public:
 
-	MeraToTikz(PsimagLite::String srep, SizeType sites)
-	    : srep_(srep),tauMax_(ProgramGlobals::logBase2Strict(sites)-1)
+	MeraToTikz(PsimagLite::String srep, SizeType sites, SizeType arity = 2)
+	    : srep_(srep),
+	      arity_(arity),
+	      tauMax_(ProgramGlobals::logBaseStrict(sites, arity)-1)
 	{
 		buildPacking(sites);
 		fillBuffer();
@@ -194,16 +196,17 @@ private:
 			if (tensorSrep(i).type() == TensorStanza::TENSOR_TYPE_ERASED)
 				continue;
 			PsimagLite::String name = tensorSrep(i).name();
-			if (tensorSrep(i).id() >= unpackTimeAndSpace_.size())
+			const VectorPairSizeType& unpack = timeAndSpace(name);
+			if (tensorSrep(i).id() >= unpack.size())
 				continue;
-			PairSizeType tensorXY = unpackTimeAndSpace_[tensorSrep(i).id()];
+			PairSizeType tensorXY = unpack[tensorSrep(i).id()];
 			SizeType tensorX = tensorXY.first;
 			SizeType tensorY = tensorXY.second;
 
 			RealType ysign = (tensorSrep(i).isConjugate()) ? -1.0 : 1.0;
 			RealType xsep = 3.0*dx*(1+tensorY);
 			RealType xwsign = (tensorY & 1) ? -1 : 1;
-			RealType xoffset = 3.0*pow(2,tensorY);
+			RealType xoffset = 3.0*pow(arity_,tensorY);
 			if (tensorX == 0 && tensorY > 0 && name == "u") {
 				SizeType id = tensorSrep(i).id();
 				SizeType j = findTensor(tensorSrep, id, name);
@@ -215,7 +218,7 @@ private:
 				x[i] = xsep*dx*tensorX + xoffset;
 				y[i] = 3.5*tensorY*ysign + yoffset0*ysign;
 			} else if (name == "w") {
-				x[i] = xsep*dx*tensorX  + xoffset + pow(2,tensorY)*xwsign;
+				x[i] = xsep*dx*tensorX  + xoffset + pow(arity_,tensorY)*xwsign;
 				y[i] = ysign*(3.5*tensorY + 1.5) + yoffset0*ysign;
 				savedXForR[modeForSavingForR] = x[i];
 				modeForSavingForR = (modeForSavingForR == 0) ? 1 : 0;
@@ -240,8 +243,9 @@ private:
 		for (SizeType i = 0; i < ntensors; ++i) {
 			TensorStanza::TensorTypeEnum t = tensorSrep(i).type();
 			if (t != type) continue;
-			assert(tensorSrep(i).id() < unpackTimeAndSpace_.size());
-			PairSizeType layerXY = unpackTimeAndSpace_[tensorSrep(i).id()];
+			const VectorPairSizeType& unpack = timeAndSpace(tensorSrep(i).name());
+			assert(tensorSrep(i).id() < unpack.size());
+			PairSizeType layerXY = unpack[tensorSrep(i).id()];
 			if (layerXY.second != layer) continue;
 			counter++;
 		}
@@ -323,16 +327,40 @@ private:
 		return PairSizeType(ntensors,0);
 	}
 
+	const VectorPairSizeType& timeAndSpace(PsimagLite::String name) const
+	{
+		return (name == "u") ? unpackTimeAndSpaceU_ : unpackTimeAndSpace_;
+	}
+
 	void buildPacking(SizeType sites)
 	{
 		SizeType y = 0;
-		SizeType stage = sites/2;
+		SizeType stage = sites/arity_;
 		while (stage > 1) {
 			for (SizeType i = 0; i < stage; ++i)
 				unpackTimeAndSpace_.push_back(PairSizeType(i,y));
-			stage /= 2;
+			stage /= arity_;
 			y++;
 		}
+
+		// layers may have fewer u's than w's; the u's of a layer
+		// come right before its w's in the srep
+		TensorSrep tensorSrep(srep_);
+		bool afterW = false;
+		SizeType x = 0;
+		y = 0;
+		for (SizeType i = 0; i < tensorSrep.size(); ++i) {
+			PsimagLite::String name = tensorSrep(i).name();
+			if (name == "w") afterW = true;
+			if (name != "u") continue;
+			if (afterW) {
+				afterW = false;
+				x = 0;
+				y++;
+			}
+
+			unpackTimeAndSpaceU_.push_back(PairSizeType(x++,y));
+		}
 	}
 
 	RealType findXForH(SizeType indexOfH,const TensorSrep& tSrep) const
@@ -348,7 +376,7 @@ private:
 		for (SizeType i = 0; i < legs.size(); ++i) {
 			SizeType index = findTensorWithSummedLeg(legs[i],indexOfH,tSrep);
 			SizeType tmp =  tSrep(index).id();
-			summedIds += unpackTimeAndSpace_[tmp].first;
+			summedIds += timeAndSpace(tSrep(index).name())[tmp].first;
 		}
 
 		return summedIds/legs.size();
@@ -419,8 +447,10 @@ private:
 
 	static PsimagLite::String buffer_;
 	PsimagLite::String srep_;
+	SizeType arity_;
 	SizeType tauMax_;
 	VectorPairSizeType unpackTimeAndSpace_;
+	VectorPairSizeType unpackTimeAndSpaceU_;
 }; // class MeraToTikz
 
 template<typename T>
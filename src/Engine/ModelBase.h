@@ -34,6 +34,8 @@ public:
 	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
 	typedef typename PsimagLite::Vector<MatrixType*>::Type VectorMatrixType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<VectorSizeType>::Type VectorVectorSizeType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
 
 	virtual ~ModelBase() {}
 
@@ -41,7 +43,14 @@ public:
 
 	virtual const MatrixType& twoSiteHam(SizeType id) const = 0;
 
-	virtual const VectorSizeType& qOne() const = 0;
+	// qOne()[s] are the conserved charges of local state s, one per
+	// component; qOne().size() is the local dimension
+	virtual const VectorVectorSizeType& qOne() const = 0;
+
+	// one-site operators measured with MeraOptions=Observables, by name
+	virtual const VectorStringType& observableNames() const = 0;
+
+	virtual const MatrixType& observable(SizeType i) const = 0;
 };
 }
 #endif // HEISENBERG_H
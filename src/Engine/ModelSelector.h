@@ -38,15 +38,7 @@ public:
 	ModelSelector(const PsimagLite::String& name, const VectorType& hTerms)
 	    : name_(name),model_(0)
 	{
-		if (name_ == "Heisenberg") {
-			model_ = new ModelHeisenbergType(hTerms);
-		} else if (name_ == "Hubbard") {
-			model_ = new ModelHubbardType(hTerms);
-		} else {
-			PsimagLite::String s(__FILE__);
-			s += " Unknown model " + name_ + "\n";
-			throw PsimagLite::RuntimeError(s.c_str());
-		}
+		create(hTerms);
 	}
 
 	~ModelSelector()
@@ -59,8 +51,29 @@ public:
 		return *model_;
 	}
 
+	// same model with other couplings
+	void reset(const VectorType& hTerms)
+	{
+		delete model_;
+		model_ = 0;
+		create(hTerms);
+	}
+
 private:
 
+	void create(const VectorType& hTerms)
+	{
+		if (name_ == "Heisenberg") {
+			model_ = new ModelHeisenbergType(hTerms);
+		} else if (name_ == "Hubbard") {
+			model_ = new ModelHubbardType(hTerms);
+		} else {
+			PsimagLite::String s(__FILE__);
+			s += " Unknown model " + name_ + "\n";
+			throw PsimagLite::RuntimeError(s.c_str());
+		}
+	}
+
 	ModelSelector(const ModelSelector&);
 
 	ModelSelector& operator=(const ModelSelector&);
@@ -0,0 +1,404 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_PAIR_DENSITY_MATRICES_H
+#define MERA_PAIR_DENSITY_MATRICES_H
+#include <algorithm>
+#include "Vector.h"
+#include "TensorSrep.h"
+#include "ParallelEnvironHelper.h"
+
+namespace Mera {
+
+/* Two-site density matrices of any two sites of the mera.
+ * The mera and its conjugate are contracted over the causal cone of the
+ * two sites; the ins of a tensor of the cone that do not lead down to the
+ * sites are traced, since what hangs from them is isometric.
+ * The tensors of the cone of one site are taken one at a time, in the
+ * order of the mera, into states x<k>(bra legs|ket legs) with the legs of
+ * the site first, and then those through which they leave the tensors
+ * taken. These do not depend on the other site, so each site keeps them,
+ * and a pair starts from the state of each site below the first tensor
+ * of the site that the other site shares; the rest of the cone is one
+ * statement, contracted from the top down as the energy terms are.
+ */
+template<typename ComplexOrRealType>
+class PairDensityMatrices {
+
+	typedef ParallelEnvironHelper<ComplexOrRealType> ParallelEnvironHelperType;
+	typedef typename ParallelEnvironHelperType::TensorEvalBaseType TensorEvalBaseType;
+	typedef typename ParallelEnvironHelperType::PairStringSizeType PairStringSizeType;
+	typedef typename ParallelEnvironHelperType::VectorPairStringSizeType
+	VectorPairStringSizeType;
+	typedef typename ParallelEnvironHelperType::MapPairStringSizeType MapPairStringSizeType;
+	typedef typename ParallelEnvironHelperType::VectorTensorType VectorTensorType;
+	typedef typename ParallelEnvironHelperType::SrepStatementType SrepStatementType;
+	typedef typename ParallelEnvironHelperType::TensorPoolType TensorPoolType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<VectorSizeType>::Type VectorVectorSizeType;
+	typedef PsimagLite::Vector<bool>::Type VectorBoolType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+
+public:
+
+	typedef typename ParallelEnvironHelperType::TensorType TensorType;
+
+	// mera without h; tensors and names are copied, to add the states to
+	PairDensityMatrices(const TensorSrep& mera,
+	                    PsimagLite::String evaluator,
+	                    const VectorPairStringSizeType& tensorNameIds,
+	                    const MapPairStringSizeType& nameIdsTensor,
+	                    const VectorTensorType& tensors)
+	    : mera_(mera),
+	      evaluator_(evaluator),
+	      tensorNameIds_(tensorNameIds),
+	      nameIdsTensor_(nameIdsTensor),
+	      tensors_(tensors),
+	      offset_(mera.maxTag('s') + 1),
+	      chains_(mera.maxTag('f') + 1),
+	      reused_(0)
+	{}
+
+	~PairDensityMatrices()
+	{
+		for (SizeType k = 0; k < states_.size(); ++k) {
+			delete states_[k];
+			states_[k] = 0;
+		}
+	}
+
+	// x(f0,f1|f2,f3) of sites i and j, laid out as in LocalObservables
+	void operator()(TensorType& x, SizeType i, SizeType j)
+	{
+		VectorBoolType coneI;
+		VectorBoolType downI;
+		causalCone(coneI, downI, i);
+		VectorBoolType coneJ;
+		VectorBoolType downJ;
+		causalCone(coneJ, downJ, j);
+
+		VectorSizeType orderI;
+		VectorSizeType orderJ;
+		SizeType di = ownTensors(orderI, coneI, coneJ);
+		SizeType dj = ownTensors(orderJ, coneJ, coneI);
+
+		VectorBoolType rest(mera_.size(), false);
+		for (SizeType p = di; p < orderI.size(); ++p)
+			rest[orderI[p]] = true;
+		for (SizeType p = dj; p < orderJ.size(); ++p)
+			rest[orderJ[p]] = true;
+
+		VectorStringType ket(downI.size());
+		VectorStringType bra(downI.size());
+		bra[offset_ + i] = "f0";
+		bra[offset_ + j] = "f1";
+		ket[offset_ + i] = "f2";
+		ket[offset_ + j] = "f3";
+		SizeType summed = 0;
+		for (SizeType k = 0; k < mera_.size(); ++k) {
+			if (!rest[k]) continue;
+			const TensorStanza& t = mera_(k);
+			for (SizeType l = 0; l < t.legs(); ++l) {
+				SizeType tag = tagOf(t, l);
+				if (ket[tag] != "") continue;
+				ket[tag] = "s" + ttos(summed++);
+				bra[tag] = (downI[tag] || downJ[tag]) ? "s" + ttos(summed++) : ket[tag];
+			}
+		}
+
+		// the rest from the top down, each tensor next to its conjugate, and
+		// the states last, so that the sites are reached last, as in the
+		// energy terms; from the states up, the legs of both sites would
+		// stay open all the way
+		PsimagLite::String rhs;
+		for (SizeType k = mera_.size(); k > 0; --k) {
+			if (!rest[k - 1]) continue;
+			const TensorStanza& t = mera_(k - 1);
+			VectorStringType ketLegs(t.legs());
+			VectorStringType braLegs(t.legs());
+			for (SizeType l = 0; l < t.legs(); ++l) {
+				ketLegs[l] = ket[tagOf(t, l)];
+				braLegs[l] = bra[tagOf(t, l)];
+			}
+
+			rhs += stanzaSrep(t, ketLegs, "") + stanzaSrep(t, braLegs, "*");
+		}
+
+		if (di > 0) rhs += stateSrep(ascend(i, di, orderI, downI), ket, bra);
+		if (dj > 0) rhs += stateSrep(ascend(j, dj, orderJ, downJ), ket, bra);
+
+		evaluate(x, "x" + ttos(states_.size()) + "(f0,f1|f2,f3)=" + rhs);
+	}
+
+	// states computed, and times one was found computed, over all pairs so far
+	SizeType states() const { return states_.size(); }
+
+	SizeType reused() const { return reused_; }
+
+private:
+
+	PairDensityMatrices(const PairDensityMatrices&);
+
+	PairDensityMatrices& operator=(const PairDensityMatrices&);
+
+	// tensors above site, and the tags, as in tagOf(), of their legs that
+	// lead down to it
+	void causalCone(VectorBoolType& cone, VectorBoolType& down, SizeType site) const
+	{
+		cone.assign(mera_.size(), false);
+		down.assign(offset_ + mera_.maxTag('f') + 1, false);
+		down[offset_ + site] = true;
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (SizeType k = 0; k < mera_.size(); ++k) {
+				if (cone[k]) continue;
+				const TensorStanza& t = mera_(k);
+				SizeType ins = t.ins();
+				for (SizeType l = 0; l < ins; ++l) {
+					if (!down[tagOf(t, l)]) continue;
+					cone[k] = changed = true;
+					break;
+				}
+
+				if (!cone[k]) continue;
+				for (SizeType l = ins; l < t.legs(); ++l)
+					down[tagOf(t, l)] = true;
+			}
+		}
+	}
+
+	// the tensors of cone in the order of the mera, and how many of them
+	// come before the first one in the other cone
+	SizeType ownTensors(VectorSizeType& order,
+	                    const VectorBoolType& cone,
+	                    const VectorBoolType& other) const
+	{
+		order.clear();
+		SizeType own = mera_.size();
+		for (SizeType k = 0; k < mera_.size(); ++k) {
+			if (!cone[k]) continue;
+			if (other[k] && own == mera_.size()) own = order.size();
+			order.push_back(k);
+		}
+
+		return (own == mera_.size()) ? order.size() : own;
+	}
+
+	// the state of site after the first depth tensors of order, its cone
+	SizeType ascend(SizeType site,
+	                SizeType depth,
+	                const VectorSizeType& order,
+	                const VectorBoolType& down)
+	{
+		VectorSizeType& chain = chains_[site];
+		if (chain.size() >= depth) {
+			++reused_;
+			return chain[depth - 1];
+		}
+
+		while (chain.size() < depth) {
+			SizeType d = chain.size();
+			SizeType id = states_.size();
+			VectorSizeType legs;
+			PsimagLite::String rhs = stepSrep(legs, order[d], down, chain);
+			TensorType* state = new TensorType(1, legs.size());
+			evaluate(*state, "x" + ttos(id) + lhsSrep(legs.size()) + "=" + rhs);
+			states_.push_back(state);
+			legs_.push_back(legs);
+			setState(id, state);
+			chain.push_back(id);
+		}
+
+		return chain[depth - 1];
+	}
+
+	// rhs of the step of chain through tensor k, and the legs of its state:
+	// the site, the legs of the last state that k does not take, and the
+	// outs of k
+	PsimagLite::String stepSrep(VectorSizeType& legs,
+	                            SizeType k,
+	                            const VectorBoolType& down,
+	                            const VectorSizeType& chain) const
+	{
+		const TensorStanza& t = mera_(k);
+		SizeType ins = t.ins();
+		VectorSizeType tags(t.legs(), 0);
+		for (SizeType l = 0; l < t.legs(); ++l)
+			tags[l] = tagOf(t, l);
+
+		legs.clear();
+		SizeType last = (chain.size() > 0) ? chain.back() : 0;
+		for (SizeType l = 0; l < ins; ++l) {
+			if (!down[tags[l]]) continue;
+			bool below = (chain.size() > 0) ? (std::find(legs_[last].begin(),
+			                                             legs_[last].end(),
+			                                             tags[l]) != legs_[last].end())
+			                                : (tags[l] >= offset_);
+			if (!below)
+				throw PsimagLite::RuntimeError("PairDensityMatrices: " + t.name() +
+				                               ttos(t.id()) + " comes before a tensor below it\n");
+		}
+
+		if (chain.size() > 0) {
+			const VectorSizeType& v = legs_[last];
+			legs.push_back(v[0]);
+			for (SizeType p = 1; p < v.size(); ++p)
+				if (std::find(tags.begin(), tags.begin() + ins, v[p]) == tags.begin() + ins)
+					legs.push_back(v[p]);
+		} else {
+			for (SizeType l = 0; l < ins; ++l)
+				if (down[tags[l]]) legs.push_back(tags[l]);
+		}
+
+		for (SizeType l = ins; l < t.legs(); ++l)
+			legs.push_back(tags[l]);
+
+		SizeType summed = 0;
+		VectorStringType ket(t.legs());
+		VectorStringType bra(t.legs());
+		for (SizeType l = 0; l < t.legs(); ++l) {
+			bool onState = (l < ins && down[tags[l]] && chain.size() > 0);
+			if (l >= ins || (down[tags[l]] && !onState)) {
+				ket[l] = freeOf(legs, tags[l], true);
+				bra[l] = freeOf(legs, tags[l], false);
+				continue;
+			}
+
+			ket[l] = "s" + ttos(summed++);
+			bra[l] = (onState) ? "s" + ttos(summed++) : ket[l];
+		}
+
+		PsimagLite::String rhs;
+		if (chain.size() > 0) {
+			const VectorSizeType& v = legs_[last];
+			VectorStringType xket(v.size());
+			VectorStringType xbra(v.size());
+			for (SizeType p = 0; p < v.size(); ++p) {
+				SizeType l = std::find(tags.begin(), tags.begin() + ins, v[p]) - tags.begin();
+				xket[p] = (l < ins) ? ket[l] : freeOf(legs, v[p], true);
+				xbra[p] = (l < ins) ? bra[l] : freeOf(legs, v[p], false);
+			}
+
+			rhs = "x" + ttos(last) + "(" + joined(xbra, 0, v.size()) + "|" +
+			        joined(xket, 0, v.size()) + ")";
+		}
+
+		return rhs + stanzaSrep(t, ket, "") + stanzaSrep(t, bra, "*");
+	}
+
+	// state id with its legs labeled by tag
+	PsimagLite::String stateSrep(SizeType id,
+	                             const VectorStringType& ket,
+	                             const VectorStringType& bra) const
+	{
+		const VectorSizeType& v = legs_[id];
+		VectorStringType legs(2*v.size());
+		for (SizeType p = 0; p < v.size(); ++p) {
+			legs[p] = bra[v[p]];
+			legs[v.size() + p] = ket[v[p]];
+		}
+
+		return "x" + ttos(id) + "(" + joined(legs, 0, v.size()) + "|" +
+		        joined(legs, v.size(), legs.size()) + ")";
+	}
+
+	// bra legs of a state are f0 to f(n-1), and ket legs fn to f(2n-1)
+	static PsimagLite::String freeOf(const VectorSizeType& legs, SizeType tag, bool ket)
+	{
+		SizeType p = std::find(legs.begin(), legs.end(), tag) - legs.begin();
+		assert(p < legs.size());
+		return "f" + ttos((ket) ? legs.size() + p : p);
+	}
+
+	static PsimagLite::String stanzaSrep(const TensorStanza& t,
+	                                     const VectorStringType& legs,
+	                                     PsimagLite::String star)
+	{
+		SizeType ins = t.ins();
+		PsimagLite::String str = t.name() + ttos(t.id()) + star + "(" + joined(legs, 0, ins);
+		if (ins < legs.size())
+			str += "|" + joined(legs, ins, legs.size());
+		return str + ")";
+	}
+
+	static PsimagLite::String lhsSrep(SizeType n)
+	{
+		VectorStringType legs(2*n);
+		for (SizeType p = 0; p < legs.size(); ++p)
+			legs[p] = "f" + ttos(p);
+		return "(" + joined(legs, 0, n) + "|" + joined(legs, n, 2*n) + ")";
+	}
+
+	static PsimagLite::String joined(const VectorStringType& v, SizeType start, SizeType end)
+	{
+		PsimagLite::String str;
+		for (SizeType p = start; p < end; ++p)
+			str += (p == start) ? v[p] : "," + v[p];
+		return str;
+	}
+
+	// summed legs by their tag, frees by offset_ plus their site
+	SizeType tagOf(const TensorStanza& t, SizeType l) const
+	{
+		if (t.legType(l) == TensorStanza::INDEX_TYPE_SUMMED) return t.legTag(l);
+		if (t.legType(l) == TensorStanza::INDEX_TYPE_FREE) return offset_ + t.legTag(l);
+		throw PsimagLite::RuntimeError("PairDensityMatrices: leg of " + t.name() +
+		                               ttos(t.id()) + " neither summed nor free\n");
+	}
+
+	void evaluate(TensorType& x, PsimagLite::String str)
+	{
+		TensorPoolType::init(1);
+		SrepStatementType srep(str);
+		TensorEvalBaseType* tensorEval =
+		        ParallelEnvironHelperType::getTensorEvalPtr(evaluator_,
+		                                                    srep,
+		                                                    tensors_,
+		                                                    tensorNameIds_,
+		                                                    nameIdsTensor_,
+		                                                    0,
+		                                                    TensorPoolType::ofThread(0),
+		                                                    &x);
+		typename TensorEvalBaseType::HandleType handle = tensorEval->operator()();
+		while (!handle.done());
+		delete tensorEval;
+		tensorEval = 0;
+	}
+
+	// state id as tensor x<id> for the statements that follow
+	void setState(SizeType id, TensorType* state)
+	{
+		PairStringSizeType nameId("x", id);
+		nameIdsTensor_[nameId] = tensors_.size();
+		tensorNameIds_.push_back(nameId);
+		tensors_.push_back(state);
+	}
+
+	const TensorSrep& mera_;
+	PsimagLite::String evaluator_;
+	VectorPairStringSizeType tensorNameIds_;
+	MapPairStringSizeType nameIdsTensor_;
+	VectorTensorType tensors_;
+	SizeType offset_;
+	VectorVectorSizeType chains_;
+	SizeType reused_;
+	VectorTensorType states_;
+	VectorVectorSizeType legs_;
+}; // class PairDensityMatrices
+} // namespace Mera
+#endif // MERA_PAIR_DENSITY_MATRICES_H
@@ -48,6 +48,8 @@ public:
 	typedef typename TensorEvalBaseType::MapPairStringSizeType MapPairStringSizeType;
 	typedef typename TensorEvalBaseType::VectorPairStringSizeType VectorPairStringSizeType;
 	typedef typename TensorEvalSlowType::SymmetryLocalType SymmetryLocalType;
+	typedef typename TensorEvalSlowType::TensorPoolType TensorPoolType;
+	typedef typename TensorEvalSlowType::MatrixTarget MatrixTargetType;
 
 	ParallelEnvironHelper(VectorSrepStatementType& tensorSrep,
 	                      PsimagLite::String evaluator,
@@ -63,10 +65,18 @@ public:
 	      nameIdsTensor_(nameIdsTensor),
 	      tensors_(tensors),
 	      symmLocal_(symmLocal),
-	      m_(PsimagLite::Concurrency::codeSectionParams.npthreads, 0)
+	      mirrorTerms_(0),
+	      mirrorOuts_(0),
+	      m_(PsimagLite::Concurrency::codeSectionParams.npthreads, 0),
+	      out_(m_.size(), 0)
 	{
-		for (SizeType i = 0; i < m_.size(); ++i)
+		VectorSizeType args(1, 1); // bogus, setSizes comes later
+		for (SizeType i = 0; i < m_.size(); ++i) {
 			m_[i] = new MatrixType;
+			out_[i] = new TensorType(args, 0);
+		}
+
+		TensorPoolType::init(m_.size());
 	}
 
 	~ParallelEnvironHelper()
@@ -74,13 +84,33 @@ public:
 		for (SizeType i = 0; i < m_.size(); ++i) {
 			delete m_[i];
 			m_[i] = 0;
+			delete out_[i];
+			out_[i] = 0;
 		}
 	}
 
 	void doTask(SizeType taskNumber, SizeType threadNum)
 	{
 		if (taskNumber == ignore_) return;
-		appendToMatrix(*(m_[threadNum]), *(tensorSrep_[taskNumber]), evaluator_);
+		bool mirror = (mirrorTerms_ && mirrorTerms_->operator[](taskNumber) > 0);
+		double t0 = Profiler::now();
+		appendToMatrix(*(m_[threadNum]),
+		               *(tensorSrep_[taskNumber]),
+		               evaluator_,
+		               mirror,
+		               threadNum);
+		if (Profiler::tracing())
+			Profiler::addEvent(threadNum, "environ", "term " + ttos(taskNumber), t0);
+	}
+
+	// flagged terms are added again with the legs of the tensor reversed,
+	// ins and outs separately; frees are its outs followed by its ins
+	void setMirrorTerms(const VectorSizeType& mirrorTerms, SizeType outs)
+	{
+		if (mirrorTerms.size() != tensorSrep_.size())
+			throw PsimagLite::RuntimeError("setMirrorTerms: wrong number of terms\n");
+		mirrorTerms_ = &mirrorTerms;
+		mirrorOuts_ = outs;
 	}
 
 	SizeType tasks() const { return tensorSrep_.size(); }
@@ -92,12 +122,20 @@ public:
 		return *(m_[0]);
 	}
 
+	// thread 0 may have done none of the tasks, as when several helpers
+	// share one loop, so the sum goes into the first matrix that was sized
 	void sync()
 	{
 		if (m_.size() == 0) return;
 		if (!(m_[0])) return;
-		for (SizeType i = 1; i < m_.size(); ++i)
+		for (SizeType i = 1; i < m_.size(); ++i) {
+			if (m_[0]->n_row() == 0 && m_[0]->n_col() == 0) {
+				std::swap(m_[0], m_[i]);
+				continue;
+			}
+
 			checkAndAccumulate(*(m_[i]));
+		}
 	}
 
 	static TensorEvalBaseType* getTensorEvalPtr(PsimagLite::String evaluator,
@@ -105,7 +143,10 @@ public:
 	                                            VectorTensorType& tensors,
 	                                            const VectorPairStringSizeType& tensorNameIds,
 	                                            MapPairStringSizeType& nameIdsTensor,
-	                                            SymmetryLocalType* symmLocal)
+	                                            SymmetryLocalType* symmLocal,
+	                                            TensorPoolType* pool = 0,
+	                                            TensorType* output = 0,
+	                                            MatrixTargetType* target = 0)
 	{
 		TensorEvalBaseType* tensorEval = 0;
 		if (evaluator == "slow") {
@@ -113,7 +154,11 @@ public:
 			                                    tensors,
 			                                    tensorNameIds,
 			                                    nameIdsTensor,
-			                                    symmLocal);
+			                                    symmLocal,
+			                                    TensorEvalSlowType::EVAL_BREAKUP,
+			                                    pool,
+			                                    output,
+			                                    target);
 		} else if (evaluator == "new") {
 			tensorEval = new TensorEvalNewType(srep,
 			                                   tensors,
@@ -128,7 +173,9 @@ public:
 
 	void appendToMatrix(MatrixType& m,
 	                    SrepStatementType& eq,
-	                    PsimagLite::String evaluator)
+	                    PsimagLite::String evaluator,
+	                    bool mirror = false,
+	                    SizeType threadNum = 0)
 	{
 		SizeType total = eq.rhs().maxTag('f') + 1;
 		VectorSizeType freeIndices(total,0);
@@ -148,8 +195,21 @@ public:
 
 		assert(m.n_row() > 0 && m.n_col() > 0);
 
-		// prepare output tensor for evaluator
-		outputTensor(eq).setSizes(dimensions);
+		// the last contraction of eq adds into m directly; if it cannot, the
+		// output goes to a buffer of this thread, not to the output tensor
+		// of eq, so terms may share their output
+		MatrixTargetType target(m);
+		stridesOf(target.stride, dimensions, directions, m.n_row());
+		if (mirror) {
+			VectorSizeType perm;
+			mirrorPermutation(perm, dimensions, directions);
+			target.mirrorStride.resize(total, 0);
+			for (SizeType i = 0; i < total; ++i)
+				target.mirrorStride[i] = target.stride[perm[i]];
+		}
+
+		assert(threadNum < out_.size());
+		TensorType& out = *(out_[threadNum]);
 
 		// evaluate environment
 		TensorEvalBaseType* tensorEval = getTensorEvalPtr(evaluator,
@@ -157,7 +217,10 @@ public:
 		                                                  tensors_,
 		                                                  tensorNameIds_,
 		                                                  nameIdsTensor_,
-		                                                  symmLocal_);
+		                                                  symmLocal_,
+		                                                  TensorPoolType::ofThread(threadNum),
+		                                                  &out,
+		                                                  &target);
 
 		typename TensorEvalBaseType::HandleType handle = tensorEval->operator()();
 		while (!handle.done());
@@ -165,18 +228,42 @@ public:
 		delete tensorEval;
 		tensorEval = 0;
 
+		if (target.done) return;
+
 		// copy result into m
-		SizeType count = 0;
+		ComplexOrRealType* dest = &(m(0,0));
 		do {
-			PairSizeType rc = getRowAndColFromFree(freeIndices,dimensions,directions);
-			ComplexOrRealType tmp = outputTensor(eq)(freeIndices);
-			m(rc.first,rc.second) += tmp;
-			count++;
+			ComplexOrRealType tmp = out(freeIndices);
+			dest[dot(freeIndices, target.stride)] += tmp;
+			if (mirror)
+				dest[dot(freeIndices, target.mirrorStride)] += tmp;
 		} while (ProgramGlobals::nextIndex(freeIndices,dimensions,total));
 	}
 
 private:
 
+	void mirrorPermutation(VectorSizeType& perm,
+	                       const VectorSizeType& dimensions,
+	                       const VectorDirType& directions) const
+	{
+		SizeType total = dimensions.size();
+		if (mirrorOuts_ > total)
+			throw PsimagLite::RuntimeError("mirrorPermutation: too many outs\n");
+
+		SizeType ins = total - mirrorOuts_;
+		perm.resize(total);
+		for (SizeType i = 0; i < mirrorOuts_; ++i)
+			perm[i] = mirrorOuts_ - 1 - i;
+		for (SizeType i = 0; i < ins; ++i)
+			perm[mirrorOuts_ + i] = mirrorOuts_ + ins - 1 - i;
+
+		for (SizeType i = 0; i < total; ++i) {
+			if (dimensions[perm[i]] == dimensions[i] && directions[perm[i]] == directions[i])
+				continue;
+			throw PsimagLite::RuntimeError("mirrorPermutation: legs do not match\n");
+		}
+	}
+
 	void prepareFreeIndices(VectorDirType& directions,
 	                        VectorBoolType& conjugate,
 	                        VectorSizeType& dimensions,
@@ -211,6 +298,38 @@ private:
 		}
 	}
 
+	// free index i moves the element of m, in column major order, by
+	// stride[i], as getRowAndColFromFree does with rows of size nrow
+	void stridesOf(VectorSizeType& stride,
+	               const VectorSizeType& dimensions,
+	               const VectorDirType& dirs,
+	               SizeType nrow) const
+	{
+		SizeType n = dimensions.size();
+		assert(n == dirs.size());
+		stride.assign(n, 0);
+		SizeType prodRow = 1;
+		SizeType prodCol = nrow;
+		for (SizeType i = 0; i < n; ++i) {
+			if (dirs[i] == TensorStanza::INDEX_DIR_IN) {
+				stride[i] = prodRow;
+				prodRow *= dimensions[i];
+			} else {
+				stride[i] = prodCol;
+				prodCol *= dimensions[i];
+			}
+		}
+	}
+
+	static SizeType dot(const VectorSizeType& v, const VectorSizeType& w)
+	{
+		assert(v.size() == w.size());
+		SizeType sum = 0;
+		for (SizeType i = 0; i < v.size(); ++i)
+			sum += v[i]*w[i];
+		return sum;
+	}
+
 	PairSizeType getRowAndColFromFree(VectorSizeType& freeIndices,
 	                                  const VectorSizeType& dimensions,
 	                                  const VectorDirType& dirs) const
@@ -276,15 +395,6 @@ private:
 		return (dir == in) ? out : in;
 	}
 
-	TensorType& outputTensor(const SrepStatementType& eq)
-	{
-		SizeType indexOfOutputTensor = TensorEvalBaseType::indexOfOutputTensor(eq,
-		                                                                       tensorNameIds_,
-		                                                                       nameIdsTensor_);
-		assert(indexOfOutputTensor < tensors_.size());
-		return *(tensors_[indexOfOutputTensor]);
-	}
-
 	void checkAndAccumulate(const MatrixType& m) const
 	{
 		if (m.n_row() == 0 && m.n_col() == 0) return;
@@ -307,7 +417,10 @@ private:
 	MapPairStringSizeType& nameIdsTensor_;
 	VectorTensorType& tensors_;
 	SymmetryLocalType* symmLocal_;
+	const VectorSizeType* mirrorTerms_;
+	SizeType mirrorOuts_;
 	VectorMatrixType m_;
+	VectorTensorType out_;
 }; // class ParallelEnvironHelper
 }
 
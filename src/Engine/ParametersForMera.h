@@ -40,10 +40,14 @@ struct ParametersForMera {
 	      verbose(false),
 	      evaluator(eval),
 	      model(model1),
-	      tolerance(tol)
+	      tolerance(tol),
+	      polarMethod("svd"),
+	      truncationPolicy("central")
 	{}
 
 	ParametersForMera(PsimagLite::String filename)
+	    : polarMethod("svd"),
+	      truncationPolicy("central")
 	{
 		PsimagLite::IoSimple::In io(filename);
 		io.readline(options,"MeraOptions=");
@@ -55,6 +59,13 @@ struct ParametersForMera {
 		io.readline(evaluator, "evaluator=");
 		io.readline(model, "Model=");
 		io.readline(tolerance, "Tolerance=");
+		try {
+			io.readline(polarMethod, "PolarMethod=");
+		} catch (std::exception&) {}
+
+		try {
+			io.readline(truncationPolicy, "TruncationPolicy=");
+		} catch (std::exception&) {}
 	}
 
 	PsimagLite::String options;
@@ -64,12 +75,14 @@ struct ParametersForMera {
 	PsimagLite::String evaluator;
 	PsimagLite::String model;
 	RealType tolerance;
+	PsimagLite::String polarMethod;
+	PsimagLite::String truncationPolicy;
 }; // struct ParametersForMera
 
 template<typename T>
 std::ostream& operator<<(std::ostream& os, const ParametersForMera<T>& p)
 {
-	os<<"MeraOptions=none\n";
+	os<<"MeraOptions="<<((p.options == "") ? "none" : p.options)<<"\n";
 	os<<"hamiltonianConnection ";
 	os<<p.hamiltonianConnection;
 	os<<"m="<<p.m<<"\n";
@@ -77,6 +90,8 @@ std::ostream& operator<<(std::ostream& os, const ParametersForMera<T>& p)
 	os<<"evaluator="<<p.evaluator<<"\n";
 	os<<"Model="<<p.model<<"\n";
 	os<<"Tolerance="<<p.tolerance<<"\n";
+	os<<"PolarMethod="<<p.polarMethod<<"\n";
+	os<<"TruncationPolicy="<<p.truncationPolicy<<"\n";
 	return os;
 }
 
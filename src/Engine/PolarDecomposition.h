@@ -0,0 +1,280 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_POLAR_DECOMPOSITION_H
+#define MERA_POLAR_DECOMPOSITION_H
+#include "Vector.h"
+#include "Matrix.h"
+#include "BLAS.h"
+
+namespace Mera {
+
+/* Polar factor p = U V^H of y = U S V^H, for y with no more rows than
+ * columns, as needed to update an isometry from its environment.
+ * PolarMethod=svd does a full SVD.
+ * PolarMethod=newton is the Newton-Schulz iteration, matrix products only.
+ * PolarMethod=halley is the dynamically weighted Halley iteration, which
+ * needs a lower bound for the smallest singular value of y; it is taken
+ * from y q^H, with q the current isometry, and is good once the
+ * optimization settles, so that a few iterations suffice.
+ * Both iterate with the rows x rows Gram matrix, and fall back to the SVD
+ * if they do not converge, for example if y has not full rank.
+ */
+template<typename ComplexOrRealType>
+class PolarDecomposition {
+
+	static const SizeType MAX_ITER_NEWTON = 100;
+	static const SizeType MAX_ITER_HALLEY = 20;
+
+public:
+
+	typedef PsimagLite::Matrix<ComplexOrRealType> MatrixType;
+	typedef typename PsimagLite::Real<ComplexOrRealType>::Type RealType;
+	typedef typename PsimagLite::Vector<RealType>::Type VectorRealType;
+
+	enum MethodEnum {METHOD_SVD, METHOD_NEWTON, METHOD_HALLEY};
+
+	PolarDecomposition(PsimagLite::String method)
+	    : method_(METHOD_SVD), iterations_(0)
+	{
+		if (method == "newton")
+			method_ = METHOD_NEWTON;
+		else if (method == "halley")
+			method_ = METHOD_HALLEY;
+		else if (method != "svd")
+			throw PsimagLite::RuntimeError("PolarMethod=" + method + " unknown\n");
+	}
+
+	// returns the sum of the singular values of y; q, if not null, is the
+	// current polar factor, shaped like y
+	RealType operator()(MatrixType& p, const MatrixType& y, const MatrixType* q)
+	{
+		if (y.n_row() > y.n_col())
+			throw PsimagLite::RuntimeError("PolarDecomposition: more rows than columns\n");
+
+		iterations_ = 0;
+		bool done = false;
+		RealType norm = sqrt(PsimagLite::norm2(y));
+		if (method_ != METHOD_SVD && norm > 0) {
+			p = y;
+			p *= (1.0/norm);
+			RealType l = (method_ == METHOD_HALLEY) ? lowerBound(y, q, norm) : 0.0;
+			done = iterate(p, l);
+		}
+
+		if (!done) {
+			if (method_ != METHOD_SVD)
+				std::cerr<<"PolarDecomposition: no convergence, using svd\n";
+			fullSvd(p, y);
+		}
+
+		return traceOfProduct(p, y);
+	}
+
+	SizeType iterations() const { return iterations_; }
+
+private:
+
+	// for y over its norm; y q^H is close to (y y^H)^{1/2} if q is close to
+	// the answer
+	RealType lowerBound(const MatrixType& y, const MatrixType* q, RealType norm) const
+	{
+		static const RealType safe = 1e-10;
+		if (!q || q->n_row() != y.n_row() || q->n_col() != y.n_col())
+			return safe;
+
+		MatrixType a;
+		multiply(a, y, 'N', *q, 'C');
+		SizeType rows = a.n_row();
+		MatrixType h(rows, rows);
+		for (SizeType i = 0; i < rows; ++i)
+			for (SizeType j = 0; j < rows; ++j)
+				h(i,j) = 0.5*(a(i,j) + PsimagLite::conj(a(j,i)));
+
+		VectorRealType eigs(rows, 0.0);
+		diag(h, eigs, 'N');
+		RealType l = 0.5*eigs[0]/norm;
+		return (l > safe && l < 1) ? l : safe;
+	}
+
+	// x <- (3 - g) x/2 (newton) or x <- (1 + c g)^{-1} (a + b g) x (halley),
+	// where g = x x^H, and a, b, c follow from l
+	bool iterate(MatrixType& x, RealType l)
+	{
+		SizeType rows = x.n_row();
+		SizeType maxIter = (method_ == METHOD_NEWTON) ? MAX_ITER_NEWTON : MAX_ITER_HALLEY;
+		RealType tolerance = 1e-12*sqrt(static_cast<RealType>(rows));
+		RealType errorPrev = 0.0;
+		for (; iterations_ < maxIter; ++iterations_) {
+			MatrixType g;
+			multiply(g, x, 'N', x, 'C');
+			RealType error = distanceToIdentity(g);
+			if (error < tolerance) return true;
+			if (error != error || error > 1e3) return false;
+			// stagnates if y has not full rank
+			if (iterations_ > 5 && error > 0.99*errorPrev) return false;
+			errorPrev = error;
+
+			MatrixType factor(rows, rows);
+			if (method_ == METHOD_NEWTON) {
+				for (SizeType i = 0; i < rows; ++i)
+					for (SizeType j = 0; j < rows; ++j)
+						factor(i,j) = ((i == j) ? 1.5 : 0.0) - 0.5*g(i,j);
+			} else {
+				RealType a = 3.0;
+				RealType b = 1.0;
+				RealType c = 3.0;
+				weights(a, b, c, l);
+				MatrixType denominator(rows, rows);
+				MatrixType numerator(rows, rows);
+				for (SizeType i = 0; i < rows; ++i) {
+					for (SizeType j = 0; j < rows; ++j) {
+						denominator(i,j) = ((i == j) ? 1.0 : 0.0) + c*g(i,j);
+						numerator(i,j) = ((i == j) ? a : 0.0) + b*g(i,j);
+					}
+				}
+
+				if (!invert(denominator)) return false;
+				multiply(factor, denominator, 'N', numerator, 'N');
+				l *= (a + b*l*l)/(1.0 + c*l*l);
+			}
+
+			MatrixType tmp;
+			multiply(tmp, factor, 'N', x, 'N');
+			x = tmp;
+		}
+
+		return false;
+	}
+
+	// Nakatsukasa, Bai and Gygi, SIAM J. Matrix Anal. Appl. 31, 2700 (2010)
+	static void weights(RealType& a, RealType& b, RealType& c, RealType l)
+	{
+		if (l >= 1.0) return;
+		RealType l2 = l*l;
+		RealType d = pow(4.0*(1.0 - l2)/(l2*l2), 1.0/3.0);
+		RealType sqrtOnePlusD = sqrt(1.0 + d);
+		a = sqrtOnePlusD + 0.5*sqrt(8.0 - 4.0*d + 8.0*(2.0 - l2)/(l2*sqrtOnePlusD));
+		b = 0.25*(a - 1.0)*(a - 1.0);
+		c = a + b - 1.0;
+	}
+
+	void fullSvd(MatrixType& p, const MatrixType& y) const
+	{
+		MatrixType u = y;
+		VectorRealType s;
+		MatrixType vt;
+		svd('S', u, s, vt);
+		multiply(p, u, 'N', vt, 'N');
+	}
+
+	// Gauss-Jordan with partial pivoting, false if singular
+	static bool invert(MatrixType& a)
+	{
+		SizeType n = a.n_row();
+		MatrixType b(n, n);
+		for (SizeType i = 0; i < n; ++i)
+			b(i,i) = 1.0;
+
+		for (SizeType k = 0; k < n; ++k) {
+			SizeType pivot = k;
+			for (SizeType i = k + 1; i < n; ++i)
+				if (std::abs(a(i,k)) > std::abs(a(pivot,k))) pivot = i;
+			if (std::abs(a(pivot,k)) < 1e-300) return false;
+
+			for (SizeType j = 0; j < n; ++j) {
+				std::swap(a(k,j), a(pivot,j));
+				std::swap(b(k,j), b(pivot,j));
+			}
+
+			ComplexOrRealType d = 1.0/a(k,k);
+			for (SizeType j = 0; j < n; ++j) {
+				a(k,j) *= d;
+				b(k,j) *= d;
+			}
+
+			for (SizeType i = 0; i < n; ++i) {
+				if (i == k) continue;
+				ComplexOrRealType f = a(i,k);
+				if (f == 0.0) continue;
+				for (SizeType j = 0; j < n; ++j) {
+					a(i,j) -= f*a(k,j);
+					b(i,j) -= f*b(k,j);
+				}
+			}
+		}
+
+		a = b;
+		return true;
+	}
+
+	// c = op(a)*op(b), op is 'N' or 'C'
+	static void multiply(MatrixType& c,
+	                     const MatrixType& a,
+	                     char opA,
+	                     const MatrixType& b,
+	                     char opB)
+	{
+		SizeType rows = (opA == 'N') ? a.n_row() : a.n_col();
+		SizeType inner = (opA == 'N') ? a.n_col() : a.n_row();
+		SizeType cols = (opB == 'N') ? b.n_col() : b.n_row();
+		assert(inner == ((opB == 'N') ? b.n_row() : b.n_col()));
+		c.resize(rows, cols);
+		if (rows == 0 || cols == 0 || inner == 0) return;
+		psimag::BLAS::GEMM(opA,
+		                   opB,
+		                   rows,
+		                   cols,
+		                   inner,
+		                   1.0,
+		                   &(a(0,0)),
+		                   a.n_row(),
+		                   &(b(0,0)),
+		                   b.n_row(),
+		                   0.0,
+		                   &(c(0,0)),
+		                   rows);
+	}
+
+	static RealType distanceToIdentity(const MatrixType& g)
+	{
+		RealType sum = 0.0;
+		for (SizeType i = 0; i < g.n_row(); ++i) {
+			for (SizeType j = 0; j < g.n_col(); ++j) {
+				ComplexOrRealType tmp = g(i,j) - ((i == j) ? 1.0 : 0.0);
+				sum += PsimagLite::real(PsimagLite::conj(tmp)*tmp);
+			}
+		}
+
+		return sqrt(sum);
+	}
+
+	// Re Tr(p^H y), the sum of singular values of y when p is its polar factor
+	static RealType traceOfProduct(const MatrixType& p, const MatrixType& y)
+	{
+		RealType sum = 0.0;
+		for (SizeType i = 0; i < y.n_row(); ++i)
+			for (SizeType j = 0; j < y.n_col(); ++j)
+				sum += PsimagLite::real(PsimagLite::conj(p(i,j))*y(i,j));
+		return sum;
+	}
+
+	MethodEnum method_;
+	SizeType iterations_;
+}; // class PolarDecomposition
+} // namespace Mera
+#endif // MERA_POLAR_DECOMPOSITION_H
@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_PROFILER_H
+#define MERA_PROFILER_H
+#include "Vector.h"
+#include <map>
+#include <fstream>
+#include <sys/time.h>
+#include <pthread.h>
+
+namespace Mera {
+
+/* MeraOptions=Profile: totals of wall time, flops, bytes and peak size
+ * of the output, for each statement contracted and each temporary of
+ * its breakup, by evaluator and thread; and wall time of each phase
+ * (environ, svd, lanczos, energy) of optimizing each tensor.
+ * Flops and bytes are those of a dense contraction of the operands.
+ * MeraOptions=Trace: a timeline of the tasks of each thread of the
+ * Parallelizer, and of the reductions and phases of the main thread.
+ * Each thread appends only to its own buffer, so no locks are taken.
+ * write() puts them in JSON files, the timeline as Chrome trace events.
+ */
+class Profiler {
+
+public:
+
+	struct Cost {
+
+		Cost() : calls(0), seconds(0.0), flops(0.0), bytes(0.0), peak(0.0) {}
+
+		void add(const Cost& other)
+		{
+			calls += other.calls;
+			seconds += other.seconds;
+			flops += other.flops;
+			bytes += other.bytes;
+			if (peak < other.peak) peak = other.peak;
+		}
+
+		SizeType calls;
+		double seconds;
+		double flops;
+		double bytes;
+		double peak;
+	};
+
+	static void enable(PsimagLite::String file)
+	{
+		holder().file = file;
+		holder().profiling = true;
+	}
+
+	// threads of the Parallelizer, the main thread comes after them
+	static void enableTrace(PsimagLite::String file, SizeType threads)
+	{
+		holder().traceFile = file;
+		holder().events.resize(threads + 1);
+	}
+
+	// profiling or tracing
+	static bool enabled()
+	{
+		return (holder().profiling || holder().events.size() > 0);
+	}
+
+	static bool profiling() { return holder().profiling; }
+
+	static bool tracing() { return (holder().events.size() > 0); }
+
+	static SizeType mainThread()
+	{
+		SizeType n = holder().events.size();
+		return (n > 0) ? n - 1 : 0;
+	}
+
+	// to be called from thread only, whose buffer it appends to
+	static void addEvent(SizeType thread,
+	                     PsimagLite::String name,
+	                     PsimagLite::String detail,
+	                     double start)
+	{
+		VectorVectorEventType& events = holder().events;
+		if (thread >= events.size()) return;
+		events[thread].push_back(Event(name, detail, start, now()));
+	}
+
+	static double now()
+	{
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return tv.tv_sec + 1e-6*tv.tv_usec;
+	}
+
+	// kind is statement or temporary
+	static void addStatement(PsimagLite::String kind,
+	                         PsimagLite::String srep,
+	                         PsimagLite::String evaluator,
+	                         SizeType thread,
+	                         const Cost& cost)
+	{
+		Holder& h = holder();
+		if (!h.profiling) return;
+		PsimagLite::String key = kind + "\"" + evaluator + "\"" + ttos(thread) + "\"" + srep;
+		pthread_mutex_lock(&h.mutex);
+		h.statements[key].add(cost);
+		pthread_mutex_unlock(&h.mutex);
+	}
+
+	// of the main thread, from start to now
+	static void addPhase(PsimagLite::String tensor, PsimagLite::String phase, double start)
+	{
+		Holder& h = holder();
+		if (tracing())
+			addEvent(mainThread(), phase, tensor, start);
+		if (!h.profiling) return;
+
+		Cost cost;
+		cost.calls = 1;
+		cost.seconds = now() - start;
+		pthread_mutex_lock(&h.mutex);
+		h.phases[tensor + "\"" + phase].add(cost);
+		pthread_mutex_unlock(&h.mutex);
+	}
+
+	static void write()
+	{
+		writeTrace();
+
+		Holder& h = holder();
+		if (!h.profiling) return;
+
+		std::ofstream fout(h.file.c_str());
+		if (!fout)
+			throw PsimagLite::RuntimeError("Profiler: cannot write " + h.file + "\n");
+		fout.precision(12);
+
+		fout<<"{\n\"wallTime\": "<<(now() - h.start)<<",\n\"statements\": [";
+		MapStringCostType::const_iterator it = h.statements.begin();
+		for (; it != h.statements.end(); ++it) {
+			VectorStringType tokens;
+			split(tokens, it->first, 4);
+			fout<<((it == h.statements.begin()) ? "\n" : ",\n");
+			fout<<"{\"kind\": \""<<tokens[0]<<"\", \"evaluator\": \""<<tokens[1];
+			fout<<"\", \"thread\": "<<tokens[2]<<", \"srep\": \""<<tokens[3]<<"\", ";
+			writeCost(fout, it->second);
+			fout<<"}";
+		}
+
+		fout<<"\n],\n\"tensors\": [";
+		for (it = h.phases.begin(); it != h.phases.end(); ++it) {
+			VectorStringType tokens;
+			split(tokens, it->first, 2);
+			fout<<((it == h.phases.begin()) ? "\n" : ",\n");
+			fout<<"{\"tensor\": \""<<tokens[0]<<"\", \"phase\": \""<<tokens[1]<<"\", ";
+			fout<<"\"calls\": "<<it->second.calls<<", \"seconds\": "<<it->second.seconds<<"}";
+		}
+
+		fout<<"\n]\n}\n";
+		std::cerr<<"Profiler: report written to "<<h.file<<"\n";
+	}
+
+private:
+
+	struct Event {
+
+		Event(PsimagLite::String name0, PsimagLite::String detail0, double start0, double end0)
+		    : name(name0), detail(detail0), start(start0), end(end0)
+		{}
+
+		PsimagLite::String name;
+		PsimagLite::String detail;
+		double start;
+		double end;
+	};
+
+	typedef std::map<PsimagLite::String, Cost> MapStringCostType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+	typedef PsimagLite::Vector<Event>::Type VectorEventType;
+	typedef PsimagLite::Vector<VectorEventType>::Type VectorVectorEventType;
+
+	struct Holder {
+
+		Holder() : profiling(false), start(now())
+		{
+			pthread_mutex_init(&mutex, 0);
+		}
+
+		~Holder()
+		{
+			pthread_mutex_destroy(&mutex);
+		}
+
+		bool profiling;
+		double start;
+		PsimagLite::String file;
+		PsimagLite::String traceFile;
+		pthread_mutex_t mutex;
+		MapStringCostType statements;
+		MapStringCostType phases;
+		VectorVectorEventType events;
+	};
+
+	// complete events in microseconds, one row per thread
+	static void writeTrace()
+	{
+		Holder& h = holder();
+		SizeType threads = h.events.size();
+		if (threads == 0) return;
+
+		std::ofstream fout(h.traceFile.c_str());
+		if (!fout)
+			throw PsimagLite::RuntimeError("Profiler: cannot write " + h.traceFile + "\n");
+		fout.precision(15);
+
+		fout<<"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+		for (SizeType t = 0; t < threads; ++t) {
+			PsimagLite::String name = (t + 1 == threads) ? "main" : "worker " + ttos(t);
+			fout<<((t == 0) ? "\n" : ",\n");
+			fout<<"{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "<<t;
+			fout<<", \"args\": {\"name\": \""<<name<<"\"}}";
+		}
+
+		for (SizeType t = 0; t < threads; ++t) {
+			const VectorEventType& events = h.events[t];
+			for (SizeType i = 0; i < events.size(); ++i) {
+				const Event& e = events[i];
+				fout<<",\n{\"name\": \""<<e.name<<"\", \"cat\": \"mera\", \"ph\": \"X\"";
+				fout<<", \"ts\": "<<1e6*(e.start - h.start);
+				fout<<", \"dur\": "<<1e6*(e.end - e.start);
+				fout<<", \"pid\": 0, \"tid\": "<<t;
+				fout<<", \"args\": {\"detail\": \""<<e.detail<<"\"}}";
+			}
+		}
+
+		fout<<"\n]}\n";
+		std::cerr<<"Profiler: trace written to "<<h.traceFile<<"\n";
+	}
+
+	// the first call is from the main thread, in MeraSolver's constructor
+	static Holder& holder()
+	{
+		static Holder h;
+		return h;
+	}
+
+	// keys are fields joined by double quotes, which sreps do not have
+	static void split(VectorStringType& tokens, const PsimagLite::String& key, SizeType n)
+	{
+		size_t start = 0;
+		for (SizeType i = 0; i + 1 < n; ++i) {
+			size_t end = key.find('"', start);
+			tokens.push_back(key.substr(start, end - start));
+			start = end + 1;
+		}
+
+		tokens.push_back(key.substr(start));
+	}
+
+	static void writeCost(std::ofstream& fout, const Cost& cost)
+	{
+		fout<<"\"calls\": "<<cost.calls<<", \"seconds\": "<<cost.seconds;
+		fout<<", \"flops\": "<<cost.flops<<", \"bytes\": "<<cost.bytes;
+		fout<<", \"peakBytes\": "<<cost.peak;
+	}
+}; // class Profiler
+} // namespace Mera
+#endif // MERA_PROFILER_H
@@ -28,6 +28,20 @@ struct ProgramGlobals {
 	typedef PsimagLite::RandomForTests<double> RngType;
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 
+	// returns 0 unless x is a power of base
+	static SizeType logBaseStrict(SizeType x, SizeType base)
+	{
+		if (base == 2) return logBase2Strict(x);
+		if (x == 0 || base < 2) return 0;
+		SizeType counter = 0;
+		while (x % base == 0) {
+			x /= base;
+			counter++;
+		}
+
+		return (x == 1) ? counter : 0;
+	}
+
 	static SizeType logBase2Strict(SizeType x)
 	{
 		if (x == 0) return 0;
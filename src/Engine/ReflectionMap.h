@@ -0,0 +1,178 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_REFLECTION_MAP_H
+#define MERA_REFLECTION_MAP_H
+#include "Vector.h"
+#include "TensorSrep.h"
+#include "TypeToString.h"
+
+namespace Mera {
+
+/* Reflection of a 1D MERA, site i goes into site sites - 1 - i.
+ * The mirror of tensor X is the tensor Y that sits where X lands once the
+ * network is reflected; legs of Y are those of X in reverse order, ins and
+ * outs separately. The map is built from the srep of the ket and checked
+ * leg by leg, so that a network that is not mirror-symmetric throws.
+ */
+class ReflectionMap {
+
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef std::pair<SizeType, SizeType> PairSizeType;
+	typedef PsimagLite::Vector<PairSizeType>::Type VectorPairSizeType;
+
+public:
+
+	ReflectionMap(const TensorSrep& srep)
+	    : srep_(srep),
+	      sites_(srep.maxTag('f') + 1),
+	      map_(srep.size(), srep.size())
+	{
+		SizeType ntensors = srep_.size();
+		SizeType summed = srep_.maxTag('s') + 1;
+		PairSizeType none(ntensors, 0);
+		producer_.resize(summed, none);
+		consumer_.resize(summed, none);
+		siteConsumer_.resize(sites_, none);
+		findEndpoints();
+
+		bool progress = true;
+		while (progress) {
+			progress = false;
+			for (SizeType i = 0; i < ntensors; ++i) {
+				if (map_[i] < ntensors) continue;
+				if (mirrorOfFirstIn(i)) progress = true;
+			}
+		}
+
+		for (SizeType i = 0; i < ntensors; ++i)
+			checkMirror(i);
+	}
+
+	SizeType operator()(SizeType ind) const
+	{
+		assert(ind < map_.size());
+		return map_[ind];
+	}
+
+	SizeType size() const { return map_.size(); }
+
+	// bonds of h, bond c is on sites c and c + 1 modulo sites
+	SizeType bond(SizeType c) const
+	{
+		return (2*sites_ - 2 - c) % sites_;
+	}
+
+private:
+
+	void findEndpoints()
+	{
+		SizeType ntensors = srep_.size();
+		for (SizeType i = 0; i < ntensors; ++i) {
+			const TensorStanza& stanza = srep_(i);
+			SizeType ins = stanza.ins();
+			for (SizeType j = 0; j < stanza.legs(); ++j) {
+				SizeType tag = stanza.legTag(j);
+				PairSizeType p(i, (j < ins) ? j : j - ins);
+				if (stanza.legType(j) == TensorStanza::INDEX_TYPE_FREE) {
+					if (j >= ins)
+						throw PsimagLite::RuntimeError("ReflectionMap: free out\n");
+					siteConsumer_[tag] = p;
+				} else if (j < ins) {
+					consumer_[tag] = p;
+				} else {
+					producer_[tag] = p;
+				}
+			}
+		}
+	}
+
+	// the tensor that consumes the mirror of what the first in of ind consumes
+	bool mirrorOfFirstIn(SizeType ind)
+	{
+		PairSizeType p = mirrorOfIn(ind, 0);
+		if (p.first >= srep_.size()) return false;
+		if (p.second + 1 != srep_(p.first).ins())
+			throw PsimagLite::RuntimeError(notSymmetric(ind));
+		map_[ind] = p.first;
+		return true;
+	}
+
+	// tensor and in leg that the mirror of leg j of ind must be
+	PairSizeType mirrorOfIn(SizeType ind, SizeType j) const
+	{
+		const TensorStanza& stanza = srep_(ind);
+		SizeType tag = stanza.legTag(j);
+		SizeType ntensors = srep_.size();
+		if (stanza.legType(j) == TensorStanza::INDEX_TYPE_FREE)
+			return siteConsumer_[sites_ - 1 - tag];
+
+		PairSizeType source = producer_[tag];
+		if (source.first >= ntensors || map_[source.first] >= ntensors)
+			return PairSizeType(ntensors, 0);
+
+		const TensorStanza& mirror = srep_(map_[source.first]);
+		SizeType outs = mirror.outs();
+		SizeType mirrorTag = mirror.legTag(mirror.ins() + outs - 1 - source.second);
+		return consumer_[mirrorTag];
+	}
+
+	void checkMirror(SizeType ind) const
+	{
+		SizeType ntensors = srep_.size();
+		SizeType m = map_[ind];
+		if (m >= ntensors || map_[m] != ind)
+			throw PsimagLite::RuntimeError(notSymmetric(ind));
+
+		const TensorStanza& stanza = srep_(ind);
+		const TensorStanza& mirror = srep_(m);
+		SizeType ins = stanza.ins();
+		SizeType outs = stanza.outs();
+		if (stanza.name() != mirror.name() || ins != mirror.ins() || outs != mirror.outs())
+			throw PsimagLite::RuntimeError(notSymmetric(ind));
+
+		for (SizeType j = 0; j < ins; ++j) {
+			PairSizeType p = mirrorOfIn(ind, j);
+			if (p.first != m || p.second != ins - 1 - j)
+				throw PsimagLite::RuntimeError(notSymmetric(ind));
+		}
+
+		for (SizeType k = 0; k < outs; ++k) {
+			PairSizeType dest = consumer_[stanza.legTag(ins + k)];
+			PairSizeType mirrorDest = consumer_[mirror.legTag(ins + outs - 1 - k)];
+			if (dest.first >= ntensors || mirrorDest.first != map_[dest.first])
+				throw PsimagLite::RuntimeError(notSymmetric(ind));
+			if (mirrorDest.second + 1 + dest.second != srep_(dest.first).ins())
+				throw PsimagLite::RuntimeError(notSymmetric(ind));
+		}
+	}
+
+	PsimagLite::String notSymmetric(SizeType ind) const
+	{
+		PsimagLite::String str("ReflectionMap: MERA is not mirror-symmetric at ");
+		return str + srep_(ind).name() + ttos(srep_(ind).id()) + "\n";
+	}
+
+	const TensorSrep& srep_;
+	SizeType sites_;
+	VectorSizeType map_;
+	VectorPairSizeType producer_;
+	VectorPairSizeType consumer_;
+	VectorPairSizeType siteConsumer_;
+}; // class ReflectionMap
+} // namespace Mera
+#endif // MERA_REFLECTION_MAP_H
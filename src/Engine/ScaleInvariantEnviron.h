@@ -0,0 +1,306 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_SCALE_INVARIANT_ENVIRON_H
+#define MERA_SCALE_INVARIANT_ENVIRON_H
+#include <map>
+#include "Vector.h"
+#include "TypeToString.h"
+
+namespace Mera {
+
+/* Scale-invariant binary 1D MERA, translation invariant: one u and one w
+ * per layer. Layers 0 to transitional - 1 are transitional, layer
+ * transitional repeats forever.
+ *
+ * Every statement is written for a window of six sites of a layer:
+ * three-site operator a(bra|ket) below, density matrix rho(ket|bra) above,
+ * and the operator at its two inequivalent positions, left and right.
+ * a(tau + 1) is the ascended a(tau), rho(tau) the descended rho(tau + 1),
+ * and rho(transitional) is the fixed point of the repeated layer.
+ */
+class ScaleInvariantEnviron {
+
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
+	typedef std::map<PsimagLite::String, PsimagLite::String> MapStringType;
+
+	struct Stanza {
+
+		Stanza(PsimagLite::String name1, bool conjugate1)
+		    : name(name1), conjugate(conjugate1)
+		{}
+
+		PsimagLite::String name;
+		bool conjugate;
+		VectorStringType ins;
+		VectorStringType outs;
+	};
+
+	typedef PsimagLite::Vector<Stanza>::Type VectorStanzaType;
+
+	enum {INDEX_OF_OPERATOR = 10, INDEX_OF_RHO = 11};
+
+	enum {POSITIONS = 2};
+
+public:
+
+	ScaleInvariantEnviron(SizeType d, SizeType m, SizeType transitional)
+	    : dims_(transitional + 2, d),
+	      counterForOutput_(100),
+	      envs_(""),
+	      dsrep_("")
+	{
+		if (m == 0)
+			throw PsimagLite::RuntimeError("ScaleInvariant: m must be given\n");
+
+		for (SizeType i = 1; i < dims_.size(); ++i)
+			dims_[i] = std::min(dims_[i - 1]*dims_[i - 1], m);
+
+		if (dims_[transitional] != dims_[transitional + 1]) {
+			PsimagLite::String str("ScaleInvariant: layer " + ttos(transitional));
+			str += " does not map m=" + ttos(m) + " into itself; ";
+			throw PsimagLite::RuntimeError(str + "add transitional layers\n");
+		}
+
+		for (SizeType layer = 0; layer <= transitional; ++layer) {
+			dsrepForLayer(layer);
+			environForTensor("u", layer);
+			environForTensor("w", layer);
+			superOperator("a", layer);
+			superOperator("rho", layer);
+		}
+
+		dsrep_ += "a" + ttos(transitional + 1) + operatorDsrep(transitional + 1);
+		dsrep_ += "rho" + ttos(transitional + 1) + operatorDsrep(transitional + 1);
+		energy();
+	}
+
+	const PsimagLite::String& environs() const
+	{
+		return envs_;
+	}
+
+	const PsimagLite::String& dimensionSrep() const
+	{
+		return dsrep_;
+	}
+
+private:
+
+	void dsrepForLayer(SizeType layer)
+	{
+		PsimagLite::String d = "D" + ttos(dims_[layer]);
+		PsimagLite::String dUp = "D" + ttos(dims_[layer + 1]);
+		PsimagLite::String id = ttos(layer);
+		dsrep_ += "u" + id + "(" + d + "," + d + "|" + d + "," + d + ")";
+		dsrep_ += "w" + id + "(" + d + "," + d + "|" + dUp + ")";
+		dsrep_ += "a" + id + operatorDsrep(layer);
+		dsrep_ += "rho" + id + operatorDsrep(layer);
+	}
+
+	PsimagLite::String operatorDsrep(SizeType layer) const
+	{
+		PsimagLite::String d = "D" + ttos(dims_[layer]);
+		return "(" + d + "," + d + "," + d + "|" + d + "," + d + "," + d + ")";
+	}
+
+	// environment of u or w: erase each of its occurrences in the ket
+	void environForTensor(PsimagLite::String name, SizeType layer)
+	{
+		SizeType first = (name == "u") ? 0 : 2;
+		SizeType last = (name == "u") ? 2 : 5;
+		SizeType terms = POSITIONS*(last - first);
+
+		PsimagLite::String thisEnv("TensorId=" + name + "," + ttos(layer) + "\n");
+		thisEnv += "Terms=" + ttos(terms) + "\n";
+		thisEnv += "IgnoreTerm=" + ttos(terms) + "\n";
+		thisEnv += "Layer=" + ttos(layer) + "\n";
+		thisEnv += "FirstOfLayer=" + ttos(layer) + "\n";
+
+		for (SizeType position = 0; position < POSITIONS; ++position) {
+			VectorStanzaType window;
+			buildWindow(window, layer, position);
+			for (SizeType ind = first; ind < last; ++ind)
+				thisEnv += statement(window, ind);
+		}
+
+		envs_ += thisEnv + "\n";
+	}
+
+	// a(layer + 1) from a(layer), or rho(layer) from rho(layer + 1)
+	void superOperator(PsimagLite::String name, SizeType layer)
+	{
+		bool ascending = (name == "a");
+		SizeType id = (ascending) ? layer + 1 : layer;
+
+		PsimagLite::String thisEnv("TensorId=" + name + "," + ttos(id) + "\n");
+		thisEnv += "Terms=" + ttos(static_cast<SizeType>(POSITIONS)) + "\n";
+		thisEnv += "IgnoreTerm=" + ttos(static_cast<SizeType>(POSITIONS)) + "\n";
+		thisEnv += "Layer=" + ttos(layer) + "\n";
+		thisEnv += "FirstOfLayer=" + ttos(layer) + "\n";
+
+		for (SizeType position = 0; position < POSITIONS; ++position) {
+			VectorStanzaType window;
+			buildWindow(window, layer, position);
+			SizeType ind = (ascending) ? INDEX_OF_RHO : INDEX_OF_OPERATOR;
+			thisEnv += statement(window, ind);
+		}
+
+		envs_ += thisEnv + "\n";
+	}
+
+	void energy()
+	{
+		PsimagLite::String e("TensorId=E,0\n");
+		e += "Terms=1\n";
+		e += "IgnoreTerm=2\n";
+		e += "Environ=e0()=rho0(s0,s1,s2|s3,s4,s5)a0(s3,s4,s5|s0,s1,s2)\n";
+		envs_ += e;
+		dsrep_ += "e0()";
+	}
+
+	/* Ket: u(k1,k2|m1,m2) u(k3,k4|m3,m4) w(k0,m1|x0) w(m2,m3|x1) w(m4,k5|x2)
+	 * Bra: the same with bra labels; the lower legs of the bra are the
+	 * ones of the ket except where the operator acts.
+	 * Position 0 has the operator on sites 1, 2, 3; position 1 on 2, 3, 4.
+	 */
+	void buildWindow(VectorStanzaType& window, SizeType layer, SizeType position) const
+	{
+		SizeType firstSite = position + 1;
+		VectorStringType ket(6, "");
+		VectorStringType bra(6, "");
+		for (SizeType j = 0; j < 6; ++j) {
+			ket[j] = "k" + ttos(j);
+			bool underOperator = (j >= firstSite && j < firstSite + 3);
+			bra[j] = (underOperator) ? "b" + ttos(j) : ket[j];
+		}
+
+		buildHalfWindow(window, layer, ket, "m", "x", false);
+		buildHalfWindow(window, layer, bra, "n", "y", true);
+		assert(window.size() == INDEX_OF_OPERATOR);
+
+		Stanza a("a" + ttos(layer), false);
+		Stanza rho("rho" + ttos(layer + 1), false);
+		for (SizeType j = 0; j < 3; ++j) {
+			a.ins.push_back(bra[firstSite + j]);
+			a.outs.push_back(ket[firstSite + j]);
+			rho.ins.push_back("x" + ttos(j));
+			rho.outs.push_back("y" + ttos(j));
+		}
+
+		window.push_back(a);
+		window.push_back(rho);
+	}
+
+	void buildHalfWindow(VectorStanzaType& window,
+	                     SizeType layer,
+	                     const VectorStringType& k,
+	                     PsimagLite::String middle,
+	                     PsimagLite::String top,
+	                     bool conjugate) const
+	{
+		PsimagLite::String u = "u" + ttos(layer);
+		PsimagLite::String w = "w" + ttos(layer);
+		VectorStringType m(5, "");
+		for (SizeType j = 1; j < 5; ++j)
+			m[j] = middle + ttos(j);
+
+		window.push_back(makeStanza(u, conjugate, k[1], k[2], m[1], m[2]));
+		window.push_back(makeStanza(u, conjugate, k[3], k[4], m[3], m[4]));
+		window.push_back(makeStanza(w, conjugate, k[0], m[1], top + "0", ""));
+		window.push_back(makeStanza(w, conjugate, m[2], m[3], top + "1", ""));
+		window.push_back(makeStanza(w, conjugate, m[4], k[5], top + "2", ""));
+	}
+
+	Stanza makeStanza(PsimagLite::String name,
+	                  bool conjugate,
+	                  PsimagLite::String in0,
+	                  PsimagLite::String in1,
+	                  PsimagLite::String out0,
+	                  PsimagLite::String out1) const
+	{
+		Stanza stanza(name, conjugate);
+		stanza.ins.push_back(in0);
+		stanza.ins.push_back(in1);
+		stanza.outs.push_back(out0);
+		if (out1 != "")
+			stanza.outs.push_back(out1);
+		return stanza;
+	}
+
+	// legs of the erased stanza become frees: its outs are the ins of the
+	// output, as in the matrix that ParallelEnvironHelper builds
+	PsimagLite::String statement(const VectorStanzaType& window, SizeType erased)
+	{
+		VectorStringType frees = window[erased].outs;
+		frees.insert(frees.end(), window[erased].ins.begin(), window[erased].ins.end());
+		SizeType insOfOutput = window[erased].outs.size();
+
+		MapStringType tags;
+		for (SizeType i = 0; i < frees.size(); ++i)
+			tags[frees[i]] = "f" + ttos(i);
+
+		PsimagLite::String rhs("");
+		SizeType summed = 0;
+		for (SizeType i = 0; i < window.size(); ++i) {
+			if (i == erased) continue;
+			const Stanza& stanza = window[i];
+			rhs += stanza.name;
+			if (stanza.conjugate) rhs += "*";
+			rhs += "(" + legs(stanza.ins, tags, summed);
+			if (stanza.outs.size() > 0)
+				rhs += "|" + legs(stanza.outs, tags, summed);
+			rhs += ")";
+		}
+
+		PsimagLite::String output = "u" + ttos(counterForOutput_++);
+		PsimagLite::String lhs = output + "(";
+		PsimagLite::String d = output + "(";
+		for (SizeType i = 0; i < frees.size(); ++i) {
+			PsimagLite::String sep = (i == 0) ? "" : ",";
+			if (i == insOfOutput) sep = "|";
+			lhs += sep + tags[frees[i]];
+			d += sep + "D1";
+		}
+
+		dsrep_ += d + ")";
+		return "Environ=" + lhs + ")=" + rhs + "\n";
+	}
+
+	PsimagLite::String legs(const VectorStringType& labels,
+	                        MapStringType& tags,
+	                        SizeType& summed) const
+	{
+		PsimagLite::String str("");
+		for (SizeType i = 0; i < labels.size(); ++i) {
+			if (tags.count(labels[i]) == 0)
+				tags[labels[i]] = "s" + ttos(summed++);
+			if (i > 0) str += ",";
+			str += tags[labels[i]];
+		}
+
+		return str;
+	}
+
+	VectorSizeType dims_;
+	SizeType counterForOutput_;
+	PsimagLite::String envs_;
+	PsimagLite::String dsrep_;
+}; // class ScaleInvariantEnviron
+} // namespace Mera
+#endif // MERA_SCALE_INVARIANT_ENVIRON_H
@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_SUPER_OPERATOR_H
+#define MERA_SUPER_OPERATOR_H
+#include "Vector.h"
+#include "ParallelEnvironHelper.h"
+#include "Parallelizer.h"
+
+namespace Mera {
+
+/* Ascending (a) or descending (rho) superoperator of one layer.
+ * The input block is the one of TensorOptimizer; the result is the
+ * average over the terms, stored in tensor name,id.
+ */
+template<typename ComplexOrRealType, typename IoInType>
+class SuperOperator {
+
+	typedef ParallelEnvironHelper<ComplexOrRealType> ParallelEnvironHelperType;
+	typedef typename ParallelEnvironHelperType::SymmetryLocalType SymmetryLocalType;
+
+public:
+
+	typedef typename ParallelEnvironHelperType::MatrixType MatrixType;
+	typedef typename ParallelEnvironHelperType::PairStringSizeType PairStringSizeType;
+	typedef typename ParallelEnvironHelperType::VectorPairStringSizeType
+	VectorPairStringSizeType;
+	typedef typename ParallelEnvironHelperType::MapPairStringSizeType MapPairStringSizeType;
+	typedef typename ParallelEnvironHelperType::TensorType TensorType;
+	typedef typename ParallelEnvironHelperType::VectorTensorType VectorTensorType;
+	typedef typename ParallelEnvironHelperType::SrepStatementType SrepStatementType;
+	typedef typename PsimagLite::Vector<SrepStatementType*>::Type VectorSrepStatementType;
+
+	SuperOperator(IoInType& io,
+	              PsimagLite::String name,
+	              SizeType id,
+	              const VectorPairStringSizeType& tensorNameAndIds,
+	              MapPairStringSizeType& nameIdsTensor,
+	              VectorTensorType& tensors)
+	    : nameId_(name, id),
+	      tensorNameIds_(tensorNameAndIds),
+	      nameIdsTensor_(nameIdsTensor),
+	      tensors_(tensors),
+	      layer_(0),
+	      ignore_(0)
+	{
+		io.readline(layer_,"Layer=");
+		SizeType firstOfLayer = 0;
+		io.readline(firstOfLayer,"FirstOfLayer=");
+
+		io.readline(ignore_,"IgnoreTerm=");
+		SizeType terms = 0;
+		io.readline(terms,"Terms=");
+		if (terms == 0)
+			throw PsimagLite::RuntimeError("SuperOperator: no terms for " + name + "\n");
+
+		tensorSrep_.resize(terms,0);
+
+		PsimagLite::String findStr = "Environ=";
+		for (SizeType i = 0; i < terms; ++i) {
+			PsimagLite::String srep;
+			io.readline(srep,findStr);
+			tensorSrep_[i] = new SrepStatementType(srep);
+		}
+	}
+
+	~SuperOperator()
+	{
+		for (SizeType i = 0; i < tensorSrep_.size(); ++i) {
+			delete tensorSrep_[i];
+			tensorSrep_[i] = 0;
+		}
+	}
+
+	void apply(PsimagLite::String evaluator)
+	{
+		typedef PsimagLite::Parallelizer<ParallelEnvironHelperType> ParallelizerType;
+		ParallelizerType threadedEnviron(PsimagLite::Concurrency::codeSectionParams);
+
+		ParallelEnvironHelperType helper(tensorSrep_,
+		                                 evaluator,
+		                                 ignore_,
+		                                 tensorNameIds_,
+		                                 nameIdsTensor_,
+		                                 tensors_,
+		                                 0);
+
+		threadedEnviron.loopCreate(helper);
+		helper.sync();
+
+		MatrixType m = helper.matrix();
+		m *= (1.0/tensorSrep_.size());
+		tensor().setToMatrix(m);
+	}
+
+	TensorType& tensor()
+	{
+		SizeType ind = nameIdsTensor_[nameId_];
+		assert(ind < tensors_.size());
+		return *(tensors_[ind]);
+	}
+
+	const PairStringSizeType& nameId() const { return nameId_; }
+
+	SizeType layer() const { return layer_; }
+
+private:
+
+	SuperOperator(const SuperOperator&);
+
+	SuperOperator& operator=(const SuperOperator&);
+
+	PairStringSizeType nameId_;
+	const VectorPairStringSizeType& tensorNameIds_;
+	MapPairStringSizeType& nameIdsTensor_;
+	VectorTensorType& tensors_;
+	SizeType layer_;
+	SizeType ignore_;
+	VectorSrepStatementType tensorSrep_;
+}; // class SuperOperator
+} // namespace Mera
+#endif // MERA_SUPER_OPERATOR_H
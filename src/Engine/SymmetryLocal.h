@@ -4,6 +4,8 @@
 #include "Vector.h"
 #include "Io/IoSimple.h"
 #include "Sort.h"
+#include <algorithm>
+#include <map>
 
 namespace Mera {
 
@@ -12,76 +14,115 @@ class SymmetryLocal {
 public:
 
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
-	typedef PsimagLite::Vector<VectorSizeType*>::Type VectorVectorSizeType;
-	typedef PsimagLite::Matrix<VectorSizeType*> MatrixOfQnsType;
-	typedef PsimagLite::Vector<PsimagLite::String>::Type VectorStringType;
-
-	SymmetryLocal(SizeType ntensors, const VectorSizeType& qOne, SizeType maxLegs)
-	    : qOne_(qOne), matrix_(ntensors, maxLegs), nameId_(ntensors,"")
-	{}
+	typedef PsimagLite::Vector<VectorSizeType>::Type VectorVectorSizeType;
+	typedef std::pair<PsimagLite::String,SizeType> PairStringSizeType;
+	typedef PsimagLite::Vector<PairStringSizeType>::Type VectorPairStringSizeType;
+
+	enum PolicyEnum {POLICY_CENTRAL, POLICY_LARGEST};
+
+	// handle of a leg without charges
+	static const SizeType NO_CHARGES = static_cast<SizeType>(-1);
+
+	// qOne[s] are the charges of local state s, all with the same number
+	// of components, each conserved on its own;
+	// policy says which charge sectors of a bond get the states that a
+	// truncation in proportion to sector size leaves over:
+	// central, those closest to the median charge of the product states;
+	// largest, those with most states
+	SymmetryLocal(SizeType ntensors,
+	              const VectorVectorSizeType& qOne,
+	              SizeType maxLegs,
+	              PsimagLite::String policy = "central")
+	    : qOne_(qOne),
+	      components_(componentsOf(qOne)),
+	      chargeOffset_(1, 0),
+	      legOffset_(1, 0),
+	      nameId_(ntensors, PairStringSizeType("", 0)),
+	      meraTensors_(ntensors),
+	      policy_(POLICY_CENTRAL)
+	{
+		if (policy == "largest")
+			policy_ = POLICY_LARGEST;
+		else if (policy != "central")
+			throw PsimagLite::RuntimeError("TruncationPolicy=" + policy + " unknown\n");
+
+		handleOfQOne_ = addCharges(flatten(qOne_));
+		for (SizeType i = 0; i < ntensors; ++i)
+			addLegs(maxLegs);
+	}
 
 	SymmetryLocal(PsimagLite::String filename)
+	    : components_(1),
+	      chargeOffset_(1, 0),
+	      legOffset_(1, 0),
+	      meraTensors_(0),
+	      policy_(POLICY_CENTRAL)
 	{
 		PsimagLite::IoSimple::In io(filename);
 
-		io.read(qOne_,"qOne");
+		try {
+			io.readline(components_, "ChargeComponents=");
+		} catch (std::exception&) {
+			io.rewind();
+		}
+
+		if (components_ == 0)
+			throw PsimagLite::RuntimeError("SymmetryLocal: ChargeComponents=0\n");
+
+		VectorSizeType flat;
+		io.read(flat,"qOne");
+		unflatten(qOne_, flat);
+		componentsOf(qOne_);
+		handleOfQOne_ = addCharges(flat);
 
 		int total = 0;
 		io.readline(total, "SymmTensors=");
 		if (total < 1)
 			throw PsimagLite::RuntimeError("SymmetryLocal: reading SymmTensors failed\n");
 
-		nameId_.resize(total);
-
 		int maxLegs = 0;
 		io.readline(maxLegs, "MaxLegs=");
 		if (maxLegs < 1)
 			throw PsimagLite::RuntimeError("SymmetryLocal: reading maxLegs failed\n");
 
-		matrix_.setTo(0);
-		matrix_.resize(total, maxLegs);
+		nameId_.resize(total);
+		meraTensors_ = total;
 		for (int i = 0; i < total; ++i) {
+			addLegs(maxLegs);
+
 			PsimagLite::String tmp;
 			io.readline(tmp, "SymmForTensor=");
-			nameId_[i] = tmp;
+			setNameId(i, splitNameId(tmp));
 
 			int x = 0;
 			io.readline(x, "Total=");
-			if (x < 1)
+			if (x < 1 || x > maxLegs)
 				throw PsimagLite::RuntimeError("SymmetryLocal: reading file failed\n");
 			for (int j = 0; j < x; ++j) {
-				VectorSizeType* v = new VectorSizeType;
-				io.read(*v, "Leg" + ttos(j));
-				matrix_(i,j) = v;
-				garbage_.push_back(v);
+				VectorSizeType v;
+				io.read(v, "Leg" + ttos(j));
+				setQ(i, j, addCharges(v));
 			}
 		}
 	}
 
-	~SymmetryLocal()
-	{
-		for (SizeType i = 0; i < garbage_.size(); ++i) {
-			delete garbage_[i];
-			garbage_[i] = 0;
-		}
-	}
-
 	void save(std::ostream& os) const
 	{
+		os<<"ChargeComponents="<<components_<<"\n";
 		os<<"qOne\n";
-		os<<vectorToString(qOne_);
+		os<<vectorToString(flatten(qOne_));
 		os<<"\n";
-		SizeType n = matrix_.n_row();
-		SizeType m = matrix_.n_col();
+		SizeType n = nameId_.size();
 		os<<"SymmTensors="<<effectiveTensors()<<"\n";
-		os<<"MaxLegs="<<m<<"\n";
+		os<<"MaxLegs="<<maxLegs()<<"\n";
 		for (SizeType i = 0; i < n; ++i) {
 			PsimagLite::String str("");
 			SizeType count = 0;
-			for (SizeType j = 0; j < m; ++j) {
-				if (matrix_(i,j) == 0) continue;
-				const VectorSizeType& v = *(matrix_(i,j));
-				if (v.size() == 0) continue;
+			for (SizeType j = 0; j < legs(i); ++j) {
+				SizeType h = handle(i, j);
+				if (h == NO_CHARGES || chargesSize(h) == 0) continue;
+				VectorSizeType v;
+				charges(v, h);
 				str += "Leg" + ttos(j) + " ";
 				str += vectorToString(v);
 				str += "\n";
@@ -89,105 +130,147 @@ public:
 			}
 
 			if (count == 0) continue;
-			os<<"SymmForTensor="<<nameId_[i]<<"\n";
+			os<<"SymmForTensor="<<nameId_[i].first<<nameId_[i].second<<"\n";
 			os<<"Total="<<ttos(count)<<"\n";
 			os<<str;
 		}
 	}
 
-	void addTensor(PsimagLite::String str,
-	               VectorVectorSizeType& q,
+	// appends a tensor whose leg j has the charges of handle q[iperm[j]];
+	// amortized O(legs)
+	void addTensor(const PairStringSizeType& nameId,
+	               const VectorSizeType& q,
 	               const VectorSizeType& iperm)
 	{
-		nameId_.push_back(str);
-		indexOfNameId_[str] = nameId_.size() - 1;
-		SizeType nrow = matrix_.n_row();
-		SizeType ncol = matrix_.n_col();
-		MatrixOfQnsType m(nrow + 1, ncol);
-		for (SizeType i = 0; i < nrow; ++i)
-			for (SizeType j = 0; j < ncol; ++j)
-				m(i, j) = matrix_(i, j);
-
-		for (SizeType i = 0; i < q.size(); ++i) {
-			m(nrow, i) = q[iperm[i]];
-			garbage_.push_back(q[iperm[i]]);
-		}
-
-		matrix_ = m;
+		SizeType ind = nameId_.size();
+		nameId_.push_back(PairStringSizeType("", 0));
+		setNameId(ind, nameId);
+		addLegs(q.size());
+		for (SizeType j = 0; j < q.size(); ++j)
+			setQ(ind, j, q[iperm[j]]);
 	}
 
-	void setNameId(SizeType i, PsimagLite::String str)
+	void setNameId(SizeType i, const PairStringSizeType& nameId)
 	{
 		assert(i < nameId_.size());
-		nameId_[i] = str;
+		if (nameId_[i].first != "") indexOfNameId_.erase(nameId_[i]);
+		nameId_[i] = nameId;
+		indexOfNameId_[nameId] = i;
 	}
 
 	void setQ(SizeType tensorIndex, SizeType legTag)
 	{
-		matrix_(tensorIndex,legTag) = &qOne_;
+		setQ(tensorIndex, legTag, handleOfQOne_);
 	}
 
-	void setQ(SizeType tensorIndex, SizeType legTag, VectorSizeType* q)
+	// legs with the same handle share their charges
+	void setQ(SizeType tensorIndex, SizeType legTag, SizeType h)
 	{
-		matrix_(tensorIndex,legTag) = q;
+		assert(h == NO_CHARGES || h + 1 < chargeOffset_.size());
+		legHandle_[legIndex(tensorIndex, legTag)] = h;
 	}
 
+	// If previous is given, the states kept there come first, so that
+	// tensors computed with a smaller m can be embedded into the new ones
 	void setQ(SizeType tensorIndex,
 	          SizeType legTag,
-	          const VectorVectorSizeType& q,
+	          const VectorSizeType& q,
 	          const VectorSizeType& dim,
-	          SizeType m)
+	          SizeType m,
+	          const SymmetryLocal* previous = 0)
 	{
 		assert(q.size() == dim.size());
 		SizeType total = productOf(dim); // untrucated
-		VectorSizeType* qq = new VectorSizeType(total, 0);
-		garbage_.push_back(qq);
-		fillProdVector(*qq,q,dim);
-		truncateVector(*qq, m);
-		matrix_(tensorIndex,legTag) = qq;
+		VectorSizeType qq(total*components_, 0);
+		fillProdVector(qq,q,dim);
+		SizeType hPrevious = (previous) ?
+		            previous->handleIfAny(tensorIndex, legTag) : NO_CHARGES;
+		if (hPrevious != NO_CHARGES) {
+			VectorSizeType kept;
+			previous->charges(kept, hPrevious);
+			expandVector(qq, m, kept);
+		} else {
+			truncateVector(qq, m);
+		}
+
+		setQ(tensorIndex, legTag, addCharges(qq));
 	}
 
-	void addIdentity(SizeType id, SizeType dim)
+	void addIdentity(SizeType id, SizeType dim, SizeType legs = 1)
 	{
-		VectorVectorSizeType q(2, static_cast<VectorSizeType*>(0));
-		VectorSizeType* qq = new VectorSizeType(dim, 0);
-		PsimagLite::String str("i");
-		str += ttos(id);
+		VectorSizeType range(dim*components_, 0);
 		for (SizeType i = 0; i < dim; ++i)
-			(*qq)[i] = i;
+			range[i*components_] = i;
 
-		q[0] = qq;
+		VectorSizeType q(2*legs, addCharges(range));
+		VectorSizeType iperm(2*legs, 0);
+		for (SizeType j = 0; j < q.size(); ++j)
+			iperm[j] = j;
 
-		VectorSizeType* qq2 = new VectorSizeType(dim, 0);
-		(*qq2) = (*qq);
+		addTensor(PairStringSizeType("i", id), q, iperm);
+	}
 
-		q[1] = qq2;
+	SizeType size() const { return nameId_.size(); }
 
-        addTensor(str, q, *qq);
+	SizeType handle(SizeType tensorIndex, SizeType legTag) const
+	{
+		SizeType h = legHandle_[legIndex(tensorIndex, legTag)];
+		assert(h != NO_CHARGES);
+		return h;
 	}
 
-	SizeType size() const { return nameId_.size(); }
+	// NO_CHARGES if tensorIndex is not a tensor or has no such leg
+	SizeType handleIfAny(SizeType tensorIndex, SizeType legTag) const
+	{
+		if (tensorIndex >= nameId_.size() || legTag >= legs(tensorIndex))
+			return NO_CHARGES;
+		return legHandle_[legIndex(tensorIndex, legTag)];
+	}
 
-	VectorSizeType* q(SizeType tensorIndex, SizeType legTag)
+	SizeType charge(SizeType tensorIndex,
+	                SizeType legTag,
+	                SizeType state,
+	                SizeType component) const
 	{
-		assert(matrix_(tensorIndex,legTag));
-		return matrix_(tensorIndex,legTag);
+		SizeType h = handle(tensorIndex, legTag);
+		assert(state < chargesSize(h) && component < components_);
+		return charges_[chargeOffset_[h] + state*components_ + component];
 	}
 
-	SizeType nameIdToIndex(PsimagLite::String str) const
+	SizeType components() const { return components_; }
+
+	// tensors of the MERA, whose charges DimensionSrep set, come first;
+	// outputs added later, environments for example, need not conserve
+	bool isMeraTensor(SizeType tensorIndex) const
 	{
-		if (indexOfNameId_.size() == 0)
-			nameIdToIndex();
+		return (tensorIndex < meraTensors_);
+	}
 
-		if (indexOfNameId_.count(str) == 0)
-			return nameId_.size();
+	// in states, of legs 0 to ins - 1, and out states, of the other legs,
+	// numbered first leg fastest as Tensor packs them, are in the same
+	// sector if they have the same charges
+	void sectorsOf(VectorSizeType& sectorOfIn,
+	               VectorSizeType& sectorOfOut,
+	               SizeType tensorIndex,
+	               const VectorSizeType& dim,
+	               SizeType ins) const
+	{
+		VectorSizeType q;
+		std::map<VectorSizeType, SizeType> sectors;
+		chargesOfStates(q, tensorIndex, dim, 0, ins);
+		labelSectors(sectorOfIn, q, sectors);
+		chargesOfStates(q, tensorIndex, dim, ins, dim.size());
+		labelSectors(sectorOfOut, q, sectors);
+	}
 
-		SizeType ind = indexOfNameId_[str];
-		assert(ind < nameId_.size() && nameId_[ind] == str);
-		return ind;
+	// size() if not found
+	SizeType tensorIndex(const PairStringSizeType& nameId) const
+	{
+		std::map<PairStringSizeType, SizeType>::const_iterator it = indexOfNameId_.find(nameId);
+		return (it == indexOfNameId_.end()) ? nameId_.size() : it->second;
 	}
 
-	const VectorSizeType& qOne() const { return qOne_; }
+	const VectorVectorSizeType& qOne() const { return qOne_; }
 
 	static SizeType truncateDimension(const VectorSizeType& dim, SizeType m)
 	{
@@ -198,24 +281,101 @@ public:
 
 private:
 
-	void nameIdToIndex() const
+	// q gets the charges of the product states of legs start to end - 1,
+	// first leg fastest, components_ for each state
+	void chargesOfStates(VectorSizeType& q,
+	                     SizeType tensorIndex,
+	                     const VectorSizeType& dim,
+	                     SizeType start,
+	                     SizeType end) const
 	{
-		SizeType n = nameId_.size();
-		for (SizeType i = 0; i < n; ++i)
-			indexOfNameId_[nameId_[i]] = i;
+		SizeType total = 1;
+		for (SizeType j = start; j < end; ++j)
+			total *= dim[j];
+
+		q.assign(total*components_, 0);
+		for (SizeType x = 0; x < total; ++x) {
+			SizeType tmp = x;
+			for (SizeType j = start; j < end; ++j) {
+				for (SizeType c = 0; c < components_; ++c)
+					q[x*components_ + c] += charge(tensorIndex, j, tmp % dim[j], c);
+				tmp /= dim[j];
+			}
+		}
+	}
+
+	void labelSectors(VectorSizeType& sectorOf,
+	                  const VectorSizeType& q,
+	                  std::map<VectorSizeType, SizeType>& sectors) const
+	{
+		SizeType n = q.size()/components_;
+		sectorOf.resize(n);
+		for (SizeType i = 0; i < n; ++i) {
+			VectorSizeType charge(q.begin() + i*components_, q.begin() + (i + 1)*components_);
+			std::map<VectorSizeType, SizeType>::const_iterator it = sectors.find(charge);
+			if (it == sectors.end()) {
+				sectorOf[i] = sectors.size();
+				sectors[charge] = sectorOf[i];
+			} else {
+				sectorOf[i] = it->second;
+			}
+		}
+	}
+
+	// v has the components of state 0, then those of state 1, and so on
+	SizeType addCharges(const VectorSizeType& v)
+	{
+		assert(v.size() % components_ == 0);
+		charges_.insert(charges_.end(), v.begin(), v.end());
+		chargeOffset_.push_back(charges_.size());
+		return chargeOffset_.size() - 2;
+	}
+
+	void addLegs(SizeType n)
+	{
+		legHandle_.insert(legHandle_.end(), n, static_cast<SizeType>(NO_CHARGES));
+		legOffset_.push_back(legHandle_.size());
+	}
+
+	SizeType legs(SizeType tensorIndex) const
+	{
+		assert(tensorIndex + 1 < legOffset_.size());
+		return legOffset_[tensorIndex + 1] - legOffset_[tensorIndex];
+	}
+
+	SizeType legIndex(SizeType tensorIndex, SizeType legTag) const
+	{
+		assert(legTag < legs(tensorIndex));
+		return legOffset_[tensorIndex] + legTag;
+	}
+
+	SizeType chargesSize(SizeType h) const
+	{
+		return (chargeOffset_[h + 1] - chargeOffset_[h])/components_;
+	}
+
+	void charges(VectorSizeType& v, SizeType h) const
+	{
+		v.assign(charges_.begin() + chargeOffset_[h], charges_.begin() + chargeOffset_[h + 1]);
+	}
+
+	SizeType maxLegs() const
+	{
+		SizeType max = 0;
+		for (SizeType i = 0; i < nameId_.size(); ++i)
+			max = std::max(max, legs(i));
+		return max;
 	}
 
 	SizeType effectiveTensors() const
 	{
-		SizeType n = matrix_.n_row();
-		SizeType m = matrix_.n_col();
+		SizeType n = nameId_.size();
 		SizeType counter = 0;
 		for (SizeType i = 0; i < n; ++i) {
 			SizeType count = 0;
-			for (SizeType j = 0; j < m; ++j) {
-				if (matrix_(i,j) == 0) continue;
-				const VectorSizeType& v = *(matrix_(i,j));
-				if (v.size() == 0) continue;
+			for (SizeType j = 0; j < legs(i); ++j) {
+				SizeType h = legHandle_[legIndex(i, j)];
+				if (h == NO_CHARGES || chargesSize(h) == 0) continue;
 				++count;
 			}
 
@@ -226,6 +386,17 @@ private:
 		return counter;
 	}
 
+	// u3 into (u, 3)
+	static PairStringSizeType splitNameId(PsimagLite::String str)
+	{
+		SizeType i = 0;
+		for (; i < str.length(); ++i)
+			if (isdigit(str[i])) break;
+		if (i == 0 || i == str.length())
+			throw PsimagLite::RuntimeError("SymmetryLocal: wrong tensor " + str + "\n");
+		return PairStringSizeType(str.substr(0, i), atoi(str.substr(i).c_str()));
+	}
+
 	PsimagLite::String vectorToString(const VectorSizeType& v) const
 	{
 		SizeType n = v.size();
@@ -254,26 +425,28 @@ private:
 		return ret;
 	}
 
+	// q are handles
 	void fillProdVector(VectorSizeType& qq,
-	                    const VectorVectorSizeType& q,
+	                    const VectorSizeType& q,
 	                    const VectorSizeType& dim) const
 	{
 		assert(q.size() == dim.size());
-		SizeType n = qq.size();
+		SizeType n = qq.size()/components_;
 		SizeType m = q.size();
 		VectorSizeType coordinates(m,0);
 
 		for (SizeType i = 0; i < n; ++i) {
 			unpack(coordinates,i,dim);
-			SizeType sum = 0;
-			for (SizeType j = 0; j < m; ++j) {
-				assert(q[j]);
-				const VectorSizeType& qqq = *(q[j]);
-				assert(coordinates[j] < qqq.size());
-				sum += qqq[coordinates[j]];
+			for (SizeType k = 0; k < components_; ++k) {
+				SizeType sum = 0;
+				for (SizeType j = 0; j < m; ++j) {
+					assert(q[j] != NO_CHARGES);
+					assert(coordinates[j] < chargesSize(q[j]));
+					sum += charges_[chargeOffset_[q[j]] + coordinates[j]*components_ + k];
+				}
+
+				qq[i*components_ + k] = sum;
 			}
-
-			qq[i] = sum;
 		}
 	}
 
@@ -285,7 +458,7 @@ private:
 		assert(coordinates.size() == n);
 		for (SizeType i = 0; i < n - 1; ++i) {
 			SizeType j = n - i - 1;
-			div_t x = div(tmp, dim[j - 1]);
+			div_t x = div(tmp, dim[j]);
 			coordinates[j] = x.rem;
 			assert(coordinates[j] < dim[j]);
 			tmp = x.quot;
@@ -295,53 +468,211 @@ private:
 		assert(coordinates[0] < dim[0]);
 	}
 
+	// the kept states come first, then those that a truncation of all to
+	// m would have and kept lacks, so that growing m in steps ends with
+	// the sectors of a direct truncation whenever kept allows it
+	void expandVector(VectorSizeType& qq,
+	                  SizeType m,
+	                  const VectorSizeType& kept) const
+	{
+		VectorVectorSizeType all;
+		VectorVectorSizeType sortedKept;
+		unflatten(all, qq);
+		unflatten(sortedKept, kept);
+		SizeType n = all.size();
+		SizeType newSize = (m == 0) ? n : std::min(m, n);
+		if (sortedKept.size() > newSize)
+			throw PsimagLite::RuntimeError("SymmetryLocal: m cannot decrease\n");
+
+		std::sort(all.begin(), all.end());
+		std::sort(sortedKept.begin(), sortedKept.end());
+		if (!std::includes(all.begin(), all.end(), sortedKept.begin(), sortedKept.end()))
+			throw PsimagLite::RuntimeError("SymmetryLocal: previous q not found\n");
+
+		VectorSizeType targetFlat = qq;
+		truncateVector(targetFlat, newSize);
+		VectorVectorSizeType target;
+		unflatten(target, targetFlat);
+		std::sort(target.begin(), target.end());
+
+		VectorVectorSizeType wanted(target.size());
+		VectorVectorSizeType::iterator it = std::set_difference(target.begin(),
+		                                                        target.end(),
+		                                                        sortedKept.begin(),
+		                                                        sortedKept.end(),
+		                                                        wanted.begin());
+		wanted.resize(it - wanted.begin());
+
+		SizeType extra = newSize - sortedKept.size();
+		VectorSizeType wantedFlat = flatten(wanted);
+		if (extra == 0)
+			wantedFlat.clear();
+		else
+			truncateVector(wantedFlat, extra);
+
+		qq = kept;
+		qq.insert(qq.end(), wantedFlat.begin(), wantedFlat.end());
+	}
+
+	// keeps m of the states in qq, each sector in proportion to its size,
+	// as in the density matrix of the product states with equal weights;
+	// kept states are sorted by charge, so that each sector is a range
 	void truncateVector(VectorSizeType& qq, SizeType m) const
 	{
 		if (m == 0) return;
-		SizeType n = qq.size();
+		VectorVectorSizeType sorted;
+		unflatten(sorted, qq);
+		SizeType n = sorted.size();
 		if (n <= m) return;
-		SizeType discarded = n - m;
-		assert(discarded > 0);
-		VectorSizeType r(discarded,0);
-
-#if 1
-		for (SizeType i = 0; i < discarded; ++i) {
-			r[i] = static_cast<SizeType>(drand48()*n);
-			while (std::find(r.begin(), r.begin() + i, r[i]) != r.begin() + i)
-				r[i] = static_cast<SizeType>(drand48()*n);
+
+		std::sort(sorted.begin(), sorted.end());
+
+		// component by component
+		VectorSizeType median(components_, 0);
+		VectorSizeType column(n, 0);
+		for (SizeType c = 0; c < components_; ++c) {
+			for (SizeType i = 0; i < n; ++i)
+				column[i] = sorted[i][c];
+			std::sort(column.begin(), column.end());
+			median[c] = column[n/2];
 		}
-#else
-		VectorSizeType sorted = qq;
-		PsimagLite::Sort<VectorSizeType> sort;
-		VectorSizeType iperm(qq.size());
-		sort.sort(sorted,iperm);
-		SizeType low = discarded/2;
-		SizeType high = qq.size() - discarded/2;
-		if (discarded & 1) ++low;
-		for (SizeType i = 0; i < low; ++i)
-			r[i] = iperm[i];
-
-		for (SizeType i = high; i < qq.size(); ++i)
-			r[low++] = iperm[i];
-#endif
-
-		VectorSizeType qqq(m, 0);
-		SizeType counter = 0;
-		for (SizeType i = 0; i < n; ++i) {
-			if (std::find(r.begin(), r.end(), i) != r.end())
-				continue;
-			assert(counter < qqq.size());
-			qqq[counter++] = qq[i];
+
+		// sector k has charge sorted[offset[k]] and offset[k + 1] - offset[k] states
+		VectorSizeType offset;
+		for (SizeType i = 0; i < n; ++i)
+			if (i == 0 || sorted[i] != sorted[i - 1])
+				offset.push_back(i);
+		SizeType sectors = offset.size();
+		offset.push_back(n);
+
+		VectorSizeType order(sectors, 0);
+		for (SizeType k = 0; k < sectors; ++k)
+			order[k] = k;
+		std::sort(order.begin(), order.end(), SectorLess(sorted, offset, median, policy_));
+
+		// sector k gets m*size/n states, rounded down; the states left go
+		// one each to the sectors with the largest remainders, ties in the
+		// order of policy_
+		VectorSizeType keep(sectors, 0);
+		VectorSizeType remainder(sectors, 0);
+		SizeType left = m;
+		for (SizeType k = 0; k < sectors; ++k) {
+			SizeType x = m*(offset[k + 1] - offset[k]);
+			keep[k] = x/n;
+			remainder[k] = x % n;
+			left -= keep[k];
 		}
 
-		qq = qqq;
+		std::stable_sort(order.begin(), order.end(), RemainderGreater(remainder));
+		for (SizeType i = 0; i < left; ++i)
+			++keep[order[i]];
+
+		qq.clear();
+		for (SizeType k = 0; k < sectors; ++k)
+			for (SizeType i = 0; i < keep[k]; ++i)
+				qq.insert(qq.end(), sorted[offset[k]].begin(), sorted[offset[k]].end());
+		assert(qq.size() == m*components_);
+	}
+
+	static SizeType componentsOf(const VectorVectorSizeType& q)
+	{
+		if (q.size() == 0 || q[0].size() == 0)
+			throw PsimagLite::RuntimeError("SymmetryLocal: qOne has no charges\n");
+		for (SizeType i = 1; i < q.size(); ++i)
+			if (q[i].size() != q[0].size())
+				throw PsimagLite::RuntimeError("SymmetryLocal: qOne components differ\n");
+		return q[0].size();
 	}
 
-	VectorSizeType qOne_;
-	MatrixOfQnsType matrix_;
-	VectorStringType nameId_;
-	PsimagLite::Vector<VectorSizeType*>::Type garbage_;
-	mutable std::map<PsimagLite::String, SizeType> indexOfNameId_;
+	static VectorSizeType flatten(const VectorVectorSizeType& q)
+	{
+		VectorSizeType v;
+		for (SizeType i = 0; i < q.size(); ++i)
+			v.insert(v.end(), q[i].begin(), q[i].end());
+		return v;
+	}
+
+	void unflatten(VectorVectorSizeType& q, const VectorSizeType& v) const
+	{
+		assert(v.size() % components_ == 0);
+		SizeType n = v.size()/components_;
+		q.resize(n);
+		for (SizeType i = 0; i < n; ++i)
+			q[i].assign(v.begin() + i*components_, v.begin() + (i + 1)*components_);
+	}
+
+	class RemainderGreater {
+
+	public:
+
+		RemainderGreater(const VectorSizeType& remainder)
+		    : remainder_(remainder)
+		{}
+
+		bool operator()(SizeType a, SizeType b) const
+		{
+			return (remainder_[a] > remainder_[b]);
+		}
+
+	private:
+
+		const VectorSizeType& remainder_;
+	};
+
+	class SectorLess {
+
+	public:
+
+		SectorLess(const VectorVectorSizeType& sorted,
+		           const VectorSizeType& offset,
+		           const VectorSizeType& median,
+		           PolicyEnum policy)
+		    : sorted_(sorted), offset_(offset), median_(median), policy_(policy)
+		{}
+
+		bool operator()(SizeType a, SizeType b) const
+		{
+			if (policy_ == POLICY_LARGEST && size(a) != size(b))
+				return (size(a) > size(b));
+			if (distance(a) != distance(b))
+				return (distance(a) < distance(b));
+			return (a < b);
+		}
+
+	private:
+
+		SizeType size(SizeType k) const { return offset_[k + 1] - offset_[k]; }
+
+		// summed over components
+		SizeType distance(SizeType k) const
+		{
+			const VectorSizeType& q = sorted_[offset_[k]];
+			SizeType sum = 0;
+			for (SizeType c = 0; c < q.size(); ++c)
+				sum += (q[c] > median_[c]) ? q[c] - median_[c] : median_[c] - q[c];
+			return sum;
+		}
+
+		const VectorVectorSizeType& sorted_;
+		const VectorSizeType& offset_;
+		const VectorSizeType& median_;
+		PolicyEnum policy_;
+	};
+
+	VectorVectorSizeType qOne_;
+	SizeType components_;
+	SizeType handleOfQOne_;
+	// charges of handle h are charges_[chargeOffset_[h]] up to chargeOffset_[h + 1],
+	// components_ for each state
+	VectorSizeType charges_;
+	VectorSizeType chargeOffset_;
+	// handle of leg j of tensor i is legHandle_[legOffset_[i] + j]
+	VectorSizeType legHandle_;
+	VectorSizeType legOffset_;
+	VectorPairStringSizeType nameId_;
+	std::map<PairStringSizeType, SizeType> indexOfNameId_;
+	SizeType meraTensors_;
+	PolicyEnum policy_;
 }; // class SymmetryLocal
 } // namespace Mera
 #endif // SYMMETRYLOCAL_H
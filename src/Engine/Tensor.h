@@ -121,6 +121,140 @@ public:
 				data_[x + y*dins] = m(x,y);
 	}
 
+	// copies other into the leading block, the rest is set to zero
+	void embed(const Tensor& other)
+	{
+		SizeType n = dimensions_.size();
+		if (other.args() != n)
+			throw PsimagLite::RuntimeError("Tensor::embed(...): legs differ\n");
+
+		setToConstant(0.0);
+		if (n == 0) return;
+
+		for (SizeType i = 0; i < n; ++i) {
+			if (other.argSize(i) <= dimensions_[i]) continue;
+			throw PsimagLite::RuntimeError("Tensor::embed(...): cannot shrink\n");
+		}
+
+		VectorSizeType args(n, 0);
+		do {
+			data_[pack(args)] = other(args);
+		} while (ProgramGlobals::nextIndex(args, other.dimensions_, n));
+	}
+
+	// other with its legs in reverse order, ins and outs separately
+	void setToMirrorOf(const Tensor& other)
+	{
+		SizeType n = dimensions_.size();
+		if (other.args() != n || other.ins() != ins_)
+			throw PsimagLite::RuntimeError("Tensor::setToMirrorOf(...): legs differ\n");
+
+		if (n == 0) return;
+
+		VectorSizeType args(n, 0);
+		VectorSizeType mirrorArgs(n, 0);
+		do {
+			for (SizeType i = 0; i < ins_; ++i)
+				mirrorArgs[ins_ - 1 - i] = args[i];
+			for (SizeType i = ins_; i < n; ++i)
+				mirrorArgs[n - 1 - i + ins_] = args[i];
+			data_[pack(mirrorArgs)] = other(args);
+		} while (ProgramGlobals::nextIndex(args, other.dimensions_, n));
+	}
+
+	// fills zero outs so that the tensor is an isometry again; if given,
+	// out y takes only ins x with sectorOfIn[x] == sectorOfOut[y]
+	void completeIsometry(const VectorSizeType& sectorOfIn = VectorSizeType(),
+	                      const VectorSizeType& sectorOfOut = VectorSizeType())
+	{
+		if (ins_ == 0) return;
+		if (dimensions_.size() <= ins_) return;
+
+		SizeType dins = 1;
+		for (SizeType i = 0; i < ins_; ++i)
+			dins *= dimensions_[i];
+
+		SizeType douts = 1;
+		for (SizeType i = ins_; i < dimensions_.size(); ++i)
+			douts *= dimensions_[i];
+
+		if (douts > dins)
+			throw PsimagLite::RuntimeError("Tensor::completeIsometry(...): outs > ins\n");
+
+		PsimagLite::Vector<bool>::Type done(douts, false);
+		for (SizeType y = 0; y < douts; ++y)
+			done[y] = (columnNorm(y, dins) > 1e-6);
+
+		SizeType candidate = 0;
+		for (SizeType y = 0; y < douts; ++y) {
+			if (done[y]) continue;
+
+			RealType norm = 0.0;
+			if (sectorOfOut.size() > 0) candidate = 0;
+			for (; candidate < dins; ++candidate) {
+				if (sectorOfOut.size() > 0 && sectorOfIn[candidate] != sectorOfOut[y])
+					continue;
+				for (SizeType x = 0; x < dins; ++x)
+					data_[x + y*dins] = (x == candidate) ? 1.0 : 0.0;
+
+				// twice for numerical stability
+				orthogonalize(y, dins, done);
+				orthogonalize(y, dins, done);
+				norm = columnNorm(y, dins);
+				if (norm > 1e-3) break;
+			}
+
+			if (candidate == dins)
+				throw PsimagLite::RuntimeError("Tensor::completeIsometry(...) failed\n");
+
+			++candidate;
+			for (SizeType x = 0; x < dins; ++x)
+				data_[x + y*dins] /= norm;
+			done[y] = true;
+		}
+	}
+
+	// random outs made orthonormal, an isometry away from the identity
+	void setToRandomIsometry()
+	{
+		if (ins_ == 0) return;
+		if (dimensions_.size() <= ins_) return;
+
+		SizeType dins = 1;
+		for (SizeType i = 0; i < ins_; ++i)
+			dins *= dimensions_[i];
+
+		SizeType douts = 1;
+		for (SizeType i = ins_; i < dimensions_.size(); ++i)
+			douts *= dimensions_[i];
+
+		if (douts > dins)
+			throw PsimagLite::RuntimeError("Tensor::setToRandomIsometry(...): outs > ins\n");
+
+		setToRandom();
+		PsimagLite::Vector<bool>::Type done(douts, false);
+		for (SizeType y = 0; y < douts; ++y) {
+			// twice for numerical stability
+			orthogonalize(y, dins, done);
+			orthogonalize(y, dins, done);
+			RealType norm = columnNorm(y, dins);
+			if (norm < 1e-6)
+				throw PsimagLite::RuntimeError("Tensor::setToRandomIsometry(...) failed\n");
+
+			for (SizeType x = 0; x < dins; ++x)
+				data_[x + y*dins] /= norm;
+			done[y] = true;
+		}
+	}
+
+	// for reuse as a temporary, keeps the memory of data_
+	void reset(SizeType ins)
+	{
+		dimensions_.assign(1, 1);
+		data_.resize(1);
+		ins_ = ins;
+	}
+
 	void setSizes(const VectorSizeType& dimensions)
 	{
 		if (ins_ > dimensions.size())
@@ -203,6 +337,27 @@ public:
 
 private:
 
+	RealType columnNorm(SizeType y, SizeType dins) const
+	{
+		RealType sum = 0.0;
+		for (SizeType x = 0; x < dins; ++x)
+			sum += PsimagLite::real(PsimagLite::conj(data_[x + y*dins])*data_[x + y*dins]);
+		return sqrt(sum);
+	}
+
+	void orthogonalize(SizeType y, SizeType dins, const PsimagLite::Vector<bool>::Type& done)
+	{
+		SizeType douts = done.size();
+		for (SizeType y2 = 0; y2 < douts; ++y2) {
+			if (!done[y2] || y2 == y) continue;
+			ComplexOrRealType sum = 0.0;
+			for (SizeType x = 0; x < dins; ++x)
+				sum += PsimagLite::conj(data_[x + y2*dins])*data_[x + y*dins];
+			for (SizeType x = 0; x < dins; ++x)
+				data_[x + y*dins] -= sum*data_[x + y2*dins];
+		}
+	}
+
 	static PsimagLite::RandomForTests<ComplexOrRealType> rng_;
 	VectorSizeType dimensions_;
 	VectorComplexOrRealType data_;
@@ -23,6 +23,8 @@ along with MERA++. If not, see <http://www.gnu.org/licenses/>.
 #include "TensorBreakup.h"
 #include "TensorEvalBase.h"
 #include "SymmetryLocal.h"
+#include "TensorPool.h"
+#include "Profiler.h"
 #include "BLAS.h"
 #include "PsimagLite.h"
 
@@ -33,6 +35,8 @@ class TensorEvalSlow : public TensorEvalBase<ComplexOrRealType> {
 
 	typedef TensorSrep TensorSrepType;
 
+	enum PlanEnum {PLAN_NONE, PLAN_DIRECT, PLAN_TRANSPOSED, PLAN_SCATTER};
+
 public:
 
 	typedef TensorEvalBase<ComplexOrRealType> TensorEvalBaseType;
@@ -48,29 +52,61 @@ public:
 	typedef TensorBreakup::VectorStringType VectorStringType;
 	typedef typename TensorType::MatrixType MatrixType;
 	typedef SymmetryLocal SymmetryLocalType;
-	typedef SymmetryLocalType::VectorVectorSizeType VectorVectorSizeType;
+	typedef std::pair<SizeType, SizeType> PairSizeType;
+	typedef typename PsimagLite::Vector<PairSizeType>::Type VectorPairSizeType;
+	typedef TensorPool<ComplexOrRealType> TensorPoolType;
+	typedef typename TensorPoolType::SparseOperand SparseOperandType;
 
 	static const SizeType EVAL_BREAKUP = TensorBreakup::EVAL_BREAKUP;
 
+	// operands named h with at most one nonzero in this many are sparse
+	static const SizeType SPARSE_FILL_INVERSE = 4;
+
+	// the output given to the constructor added into an environment matrix
+	// instead of written: the value at free goes to the element
+	// sum_f free[f]*stride[f] of m, in column major order, and, unless
+	// mirrorStride is empty, to sum_f free[f]*mirrorStride[f] too; done is
+	// false if the output was written after all
+	struct MatrixTarget {
+
+		MatrixTarget(MatrixType& m0) : m(m0), done(false) {}
+
+		MatrixType& m;
+		VectorSizeType stride;
+		VectorSizeType mirrorStride;
+		bool done;
+	};
+
 	TensorEvalSlow(const SrepStatementType& tSrep,
 	               const VectorTensorType& vt,
 	               const VectorPairStringSizeType& tensorNameIds,
 	               MapPairStringSizeType& nameIdsTensor,
 	               SymmetryLocalType* symmLocal,
-	               bool modify = EVAL_BREAKUP)
+	               bool modify = EVAL_BREAKUP,
+	               TensorPoolType* pool = 0,
+	               TensorType* output = 0,
+	               MatrixTarget* target = 0)
 	    : srepStatement_(tSrep),
-	      data_(vt), // deep copy
-	      tensorNameIds_(tensorNameIds), // deep copy
-	      nameIdsTensor_(nameIdsTensor), // deep copy
+	      data_(vt),
+	      tensorNameIds_(tensorNameIds),
+	      nameIdsTensor_(nameIdsTensor),
+	      overlay_(&temporaries_),
+	      redirect_(output),
+	      redirectNameId_(tSrep.nameIdOfOutput()),
 	      symmLocal_(symmLocal),
-	      modify_(modify)
+	      modify_(modify),
+	      pool_(pool),
+	      output_(0),
+	      target_(target)
 	{
-		indexOfOutputTensor_ = TensorEvalBaseType::indexOfOutputTensor(tSrep,
-		                                                               tensorNameIds,
-		                                                               nameIdsTensor);
+		output_ = tensorOf(tSrep.nameIdOfOutput());
 
 		if (!modify_) return;
 
+		bool profile = Profiler::profiling();
+		double start = (profile) ? Profiler::now() : 0.0;
+		Profiler::Cost total;
+
 		TensorBreakup tensorBreakup(srepStatement_.lhs(), srepStatement_.rhs());
 		// get t0, t1, etc definitions and result
 		VectorStringType vstr;
@@ -80,7 +116,6 @@ public:
 		assert(!(vstr.size() & 1));
 		SizeType outputLocation = 1 + vstr.size();
 		for (SizeType i = 0; i < vstr.size(); i += 2) {
-			// add them to tensorNameIds nameIdsTensor
 			PsimagLite::String temporaryName = vstr[i];
 			if (temporaryName == tSrep.lhs().sRep()) {
 				//std::cout<<"Definition of "<<srepStatement_.rhs().sRep()<<" is ";
@@ -90,39 +125,84 @@ public:
 			}
 
 			if (temporaryName[0] != 't') continue;
-			PsimagLite::String str = temporaryName.substr(1,temporaryName.length());
-			SizeType temporaryId = atoi(str.c_str());
-			temporaryName = "t";
-			PairStringSizeType tmpPair = PairStringSizeType(temporaryName,temporaryId);
-			tensorNameIds_.push_back(tmpPair);
-			nameIdsTensor_[tmpPair] = tensorNameIds_.size() - 1;
 
 			// add this temporary, call setDimensions for output tensor later
 			TensorStanza tmpStanza(vstr[i]);
-			VectorSizeType args(1,1); // bogus
-			TensorType* t = new TensorType(args, tmpStanza.ins());
+			TensorType* t = 0;
+			if (pool_) {
+				t = pool_->get(tmpStanza.ins());
+			} else {
+				VectorSizeType args(1,1); // bogus
+				t = new TensorType(args, tmpStanza.ins());
+			}
+
 			garbage_.push_back(t);
-			data_.push_back(t);
+			SizeType temporaryId = tmpStanza.id();
+			if (temporaryId >= temporaries_.size())
+				temporaries_.resize(temporaryId + 1, 0);
+			temporaries_[temporaryId] = t;
 		}
 
+		// the output statement only relabels the last temporary, so that
+		// the last contraction is the one that adds into the target
+		MatrixTarget* aliasTarget = 0;
+		PairStringSizeType aliasNameId("", 0);
+		if (target_ && outputLocation < vstr.size())
+			aliasTarget = targetOfAlias(aliasNameId, vstr[outputLocation + 1]);
+
 		VectorSrepStatementType veqs;
 		TensorSrepType::VectorPairSizeType empty;
 		for (SizeType i = 0; i < vstr.size(); i += 2) {
+			if (i == outputLocation && aliasTarget && aliasTarget->done) {
+				target_->done = true;
+				continue;
+			}
+
 			veqs.push_back(new SrepStatementType(vstr[i] + "=" + vstr[i+1]));
 			SizeType j = veqs.size() - 1;
 			if (i != outputLocation)
 				veqs[j]->canonicalize();
 			veqs[j]->rhs().simplify(empty);
 
-			TensorEvalSlow tEval(*(veqs[j]),
-			                     data_,
-			                     tensorNameIds_,
-			                     nameIdsTensor_,
-			                     symmLocal_,
-			                     false);
+			MatrixTarget* target = 0;
+			if (i == outputLocation)
+				target = target_;
+			else if (aliasTarget && veqs[j]->nameIdOfOutput() == aliasNameId)
+				target = aliasTarget;
+
+			TensorEvalSlow tEval(*(veqs[j]), *this, target);
+			double t0 = (profile) ? Profiler::now() : 0.0;
+
+			// the bra half of ket*h*bra repeats the ket half conjugated
+			VectorSizeType map;
+			SizeType k = findConjugateOf(map, veqs, j);
+			if (k < j) {
+				tEval.conjugateOf(*tensorOf(veqs[k]->nameIdOfOutput()), map);
+			} else {
+				//std::cerr<<"Evaluation of "<<veqs[j]->sRep()<<"\n";
+				tEval(); //handle the handle here
+			}
+
+			if (!profile) continue;
 
-			//std::cerr<<"Evaluation of "<<veqs[j]->sRep()<<"\n";
-			tEval(); //handle the handle here
+			Profiler::Cost cost = tEval.cost(k < j);
+			cost.seconds = Profiler::now() - t0;
+			Profiler::addStatement("temporary",
+			                       veqs[j]->sRep(),
+			                       "slow",
+			                       TensorPoolType::threadOf(pool_),
+			                       cost);
+			total.add(cost);
+		}
+
+		if (profile) {
+			total.calls = 1;
+			total.seconds = Profiler::now() - start;
+			Profiler::addStatement("statement",
+			                       tSrep.sRep(),
+			                       "slow",
+			                       TensorPoolType::threadOf(pool_),
+			                       total);
 		}
 
 		std::cout.flush();
@@ -130,10 +210,15 @@ public:
 			delete veqs[i];
 			veqs[i] = 0;
 		}
+
+		delete aliasTarget;
+		aliasTarget = 0;
 	}
 
 	~TensorEvalSlow()
 	{
+		if (pool_) pool_->release(garbage_);
+
 		for (SizeType i = 0; i < garbage_.size(); ++i) {
 			delete garbage_[i];
 			garbage_[i] = 0;
@@ -147,11 +232,11 @@ public:
 
 		SizeType total = srepStatement_.lhs().maxTag('f') + 1;
 
-		if (srepStatement_.rhs().size() == 2 && total > 0 && !symmLocal_)
+		if (srepStatement_.rhs().size() == 2 && total > 0 && !symmLocal_ && summedAreShared())
 			return operatorParensFast();
 
 		VectorSizeType dimensions(total, 0);
-		VectorVectorSizeType q(total, 0);
+		VectorSizeType q(total, static_cast<SizeType>(SymmetryLocalType::NO_CHARGES));
 
 		bool hasFree = srepStatement_.lhs().hasLegType('f');
 		if (hasFree) {
@@ -167,6 +252,8 @@ public:
 		if (dimensions.size() == 1 && dimensions[0] == 0)
 			dimensions[0] = 1;
 		outputTensor().setSizes(dimensions);
+		if (symmLocal_)
+			findSymmetricTensors();
 
 		do {
 			outputTensor()(free) = slowEvaluator(free,srepStatement_.rhs());
@@ -204,7 +291,7 @@ private:
 
 		VectorSizeType dimensions(total, 0);
 
-		VectorVectorSizeType q;
+		VectorSizeType q;
 		bool hasSummed = srep.hasLegType('s');
 		if (hasSummed) {
 			prepare(dimensions, q, srep, TensorStanza::INDEX_TYPE_SUMMED);
@@ -221,8 +308,9 @@ private:
 		return sum;
 	}
 
+	// q gets the charge handles of the free legs
 	void prepare(VectorSizeType& dimensions,
-	             VectorVectorSizeType& q,
+	             VectorSizeType& q,
 	             const TensorSrepType& tensorSrep,
 	             TensorStanza::IndexTypeEnum type) const
 	{
@@ -233,34 +321,28 @@ private:
 	}
 
 	void prepareStanza(VectorSizeType& dimensions,
-	                   VectorVectorSizeType& q,
+	                   VectorSizeType& q,
 	                   const TensorStanza& stanza,
 	                   TensorStanza::IndexTypeEnum type) const
 	{
 		SizeType id = stanza.id();
-		SizeType mid = idNameToIndex(stanza.name(),id);
+		const TensorType& t = *tensorOf(PairStringSizeType(stanza.name(),id));
+		// identities, for example, have no charges
 		SizeType tensorIndex = (symmLocal_) ?
-		            symmLocal_->nameIdToIndex(stanza.name() + ttos(id)) : 0;
-		if (symmLocal_ && tensorIndex >= symmLocal_->size())
-			assert(false);
+		            symmLocal_->tensorIndex(PairStringSizeType(stanza.name(), id)) : 0;
 
-		assert(mid < data_.size());
 		SizeType legs = stanza.legs();
 		for (SizeType j = 0; j < legs; ++j) {
 			if (stanza.legType(j) != type)
 				continue;
 			SizeType sIndex = stanza.legTag(j);
 
-			assert(j < data_[mid]->args());
+			assert(j < t.args());
 			assert(sIndex < dimensions.size());
-			dimensions[sIndex] = data_[mid]->argSize(j);
+			dimensions[sIndex] = t.argSize(j);
 			if (symmLocal_ && type == TensorStanza::INDEX_TYPE_FREE) {
-				const VectorSizeType* qSrc = symmLocal_->q(tensorIndex, j);
-				assert(qSrc);
 				assert(sIndex < q.size());
-				VectorSizeType* ptr = new VectorSizeType(qSrc->size());
-				*(ptr) = *qSrc;
-				q[sIndex] = ptr;
+				q[sIndex] = symmLocal_->handleIfAny(tensorIndex, j);
 			}
 		}
 	}
@@ -286,12 +368,11 @@ private:
 	                                  const VectorSizeType& summed,
 	                                  const VectorSizeType& free) const
 	{
-		SizeType id = ts.id();
-		SizeType mid = idNameToIndex(ts.name(),id);
+		TensorType& t = *tensorOf(PairStringSizeType(ts.name(),ts.id()));
 		SizeType legs = ts.legs();
-		assert(legs == 0 || data_[mid]->args() == legs);
+		assert(legs == 0 || t.args() == legs);
 
-		VectorSizeType args(data_[mid]->args(),0);
+		VectorSizeType args(t.args(),0);
 
 		for (SizeType j = 0; j < legs; ++j) {
 			SizeType index = ts.legTag(j);
@@ -319,40 +400,67 @@ private:
 			}
 		}
 
-		return data_[mid]->operator()(args);
+		return t(args);
 	}
 
-	bool symmetriesPass(const VectorSizeType& summed,
-	                    const VectorSizeType& free,
-	                    const TensorSrepType& tensorSrep) const
+	// tensor r (root tensor) has no out legs, so different symmetry
+	// other tensors might have different symmetry also
+	// Therefore, symmetry as implemented only applies to u and w and h
+	void findSymmetricTensors()
 	{
 		assert(symmLocal_);
+		const TensorSrepType& tensorSrep = srepStatement_.rhs();
+		symmTensors_.clear();
 		SizeType ntensors = tensorSrep.size();
 		for (SizeType i = 0; i < ntensors; ++i) {
-			// tensor r (root tensor) has no out legs, so different symmetry
-			// other tensors might have different symmetry also
-			// Therefore, symmetry as implemented only applies to u and w and h
-			PsimagLite::String name = tensorSrep(i).name();
+			const TensorStanza& ts = tensorSrep(i);
+			PsimagLite::String name = ts.name();
 			if (name != "u" && name != "w" && name != "h")
 				continue;
-			if (!symmetriesPass(tensorSrep(i),summed,free))
+			SizeType tensorIndex = symmLocal_->tensorIndex(PairStringSizeType(name, ts.id()));
+			if (tensorIndex >= symmLocal_->size())
+				throw PsimagLite::RuntimeError("No symmetry for " + name + ttos(ts.id()) + "\n");
+			// u1000 and the like are environments, named u too
+			if (!symmLocal_->isMeraTensor(tensorIndex))
+				continue;
+			symmTensors_.push_back(PairSizeType(i, tensorIndex));
+		}
+	}
+
+	bool symmetriesPass(const VectorSizeType& summed,
+	                    const VectorSizeType& free,
+	                    const TensorSrepType& tensorSrep) const
+	{
+		assert(symmLocal_);
+		for (SizeType i = 0; i < symmTensors_.size(); ++i) {
+			const TensorStanza& ts = tensorSrep(symmTensors_[i].first);
+			if (!symmetriesPass(ts, symmTensors_[i].second, summed, free))
 				return false;
 		}
 
 		return true;
 	}
 
+	// charges are conserved component by component
 	bool symmetriesPass(const TensorStanza& ts,
+	                    SizeType tensorIndex,
 	                    const VectorSizeType& summed,
 	                    const VectorSizeType& free) const
 	{
-		assert(symmLocal_);
-		PsimagLite::String tensorNameId = ts.name() + ttos(ts.id());
-		SizeType tensorIndex = symmLocal_->nameIdToIndex(tensorNameId);
-		//if (ts.maxTag('f') == 0) return true;
-		if (tensorIndex >= symmLocal_->size())
-			assert(false);
+		SizeType components = symmLocal_->components();
+		for (SizeType k = 0; k < components; ++k)
+			if (!symmetriesPass(ts, tensorIndex, k, summed, free))
+				return false;
 
+		return true;
+	}
+
+	bool symmetriesPass(const TensorStanza& ts,
+	                    SizeType tensorIndex,
+	                    SizeType component,
+	                    const VectorSizeType& summed,
+	                    const VectorSizeType& free) const
+	{
 		SizeType legs = ts.legs();
 		SizeType ins = ts.ins();
 		SizeType qin = 0;
@@ -366,12 +474,12 @@ private:
 
 			case TensorStanza::INDEX_TYPE_SUMMED:
 				assert(index < summed.size());
-				tmp = symmLocal_->q(tensorIndex,j)->operator[](summed[index]);
+				tmp = symmLocal_->charge(tensorIndex, j, summed[index], component);
 				break;
 
 			case TensorStanza::INDEX_TYPE_FREE:
 				assert(index < free.size());
-				tmp = symmLocal_->q(tensorIndex,j)->operator[](free[index]);
+				tmp = symmLocal_->charge(tensorIndex, j, free[index], component);
 				break;
 
 			case  TensorStanza::INDEX_TYPE_DUMMY:
@@ -390,6 +498,95 @@ private:
 		return (qin == qout);
 	}
 
+	// the output is the complex conjugate of other, free f of this
+	// statement being free map[f] of other
+	HandleType conjugateOf(const TensorType& other, const VectorSizeType& map)
+	{
+		HandleType handle(HandleType::STATUS_DONE);
+		SizeType total = srepStatement_.lhs().maxTag('f') + 1;
+		assert(map.size() == total);
+
+		VectorSizeType dimensions(total, 0);
+		VectorSizeType q(total, static_cast<SizeType>(SymmetryLocalType::NO_CHARGES));
+		prepare(dimensions,q,srepStatement_.rhs(),TensorStanza::INDEX_TYPE_FREE);
+		setQnsForOutput(q);
+		outputTensor().setSizes(dimensions);
+
+		VectorSizeType free(total, 0);
+		VectorSizeType otherFree(total, 0);
+		do {
+			for (SizeType i = 0; i < total; ++i)
+				otherFree[map[i]] = free[i];
+			outputTensor()(free) = PsimagLite::conj(other(otherFree));
+		} while (ProgramGlobals::nextIndex(free,dimensions,total));
+
+		return handle;
+	}
+
+	// earlier statement whose rhs is that of statement j conjugated, with
+	// the same tensors in the same order, or j if none
+	static SizeType findConjugateOf(VectorSizeType& map,
+	                                const VectorSrepStatementType& veqs,
+	                                SizeType j)
+	{
+		const TensorSrepType& b = veqs[j]->rhs();
+		if (!b.hasLegType('f')) return j;
+		if (veqs[j]->lhs().maxTag('f') != b.maxTag('f')) return j;
+		for (SizeType k = 0; k < j; ++k)
+			if (isConjugateOf(map, veqs[k]->rhs(), b)) return k;
+		return j;
+	}
+
+	static bool isConjugateOf(VectorSizeType& map,
+	                          const TensorSrepType& a,
+	                          const TensorSrepType& b)
+	{
+		SizeType ntensors = a.size();
+		SizeType frees = a.maxTag('f') + 1;
+		SizeType summed = a.maxTag('s') + 1;
+		if (b.size() != ntensors || b.maxTag('f') + 1 != frees)
+			return false;
+		if (!a.hasLegType('f') || b.maxTag('s') + 1 != summed)
+			return false;
+
+		map.assign(frees, frees);
+		VectorSizeType summedMap(summed, summed);
+		VectorSizeType used(frees + summed, 0);
+		for (SizeType i = 0; i < ntensors; ++i) {
+			const TensorStanza& sa = a(i);
+			const TensorStanza& sb = b(i);
+			if (sa.name() != sb.name() || sa.id() != sb.id()) return false;
+			if (sa.isConjugate() == sb.isConjugate()) return false;
+			if (sa.ins() != sb.ins() || sa.legs() != sb.legs()) return false;
+
+			SizeType legs = sa.legs();
+			for (SizeType l = 0; l < legs; ++l) {
+				TensorStanza::IndexTypeEnum type = sa.legType(l);
+				if (sb.legType(l) != type) return false;
+				if (type == TensorStanza::INDEX_TYPE_DUMMY) continue;
+
+				bool isFree = (type == TensorStanza::INDEX_TYPE_FREE);
+				VectorSizeType& m = (isFree) ? map : summedMap;
+				SizeType tagA = sa.legTag(l);
+				SizeType tagB = sb.legTag(l);
+				SizeType offset = (isFree) ? 0 : frees;
+				if (m[tagB] == m.size()) {
+					if (used[tagA + offset]) return false;
+					used[tagA + offset] = 1;
+					m[tagB] = tagA;
+				} else if (m[tagB] != tagA) {
+					return false;
+				}
+			}
+		}
+
+		for (SizeType f = 0; f < frees; ++f)
+			if (map[f] == frees) return false;
+
+		return true;
+	}
+
+	// two tensors sharing all summed indices: contract as a matrix product
 	HandleType operatorParensFast()
 	{
 		HandleType handle(HandleType::STATUS_DONE);
@@ -401,7 +598,7 @@ private:
 		assert(srepStatement_.rhs().size() == 2 && total > 0);
 
 		VectorSizeType dimensions(total, 0);
-		VectorVectorSizeType q(total, 0);
+		VectorSizeType q(total, static_cast<SizeType>(SymmetryLocalType::NO_CHARGES));
 
 		bool hasFree = srepStatement_.lhs().hasLegType('f');
 		if (hasFree) {
@@ -414,217 +611,534 @@ private:
 
 		if (dimensions.size() == 1 && dimensions[0] == 0)
 			dimensions[0] = 1;
-		outputTensor().setSizes(dimensions);
 
-		MatrixType m1;
-		reshapeIntoMatrix(m1, srepStatement_.rhs()(0), dimensions);
-		SizeType frees1 = m1.rows();
-		SizeType summed = m1.cols();
-		MatrixType m2;
-		reshapeIntoMatrix(m2, srepStatement_.rhs()(1), dimensions);
-		assert(summed == m2.rows());
-		SizeType frees2 = m2.cols();
-		assert(frees1*frees2 == volumeOf(dimensions));
-		MatrixType m3(frees1, frees2);
+		const TensorSrepType& rhs = srepStatement_.rhs();
+		SizeType totalSummed = rhs.maxTag('s') + 1;
+		VectorSizeType dimensionsSummed(totalSummed, 0);
+		if (rhs.hasLegType('s'))
+			prepare(dimensionsSummed, q, rhs, TensorStanza::INDEX_TYPE_SUMMED);
+
+		VectorSizeType frees0;
+		VectorSizeType frees1;
+		VectorSizeType summedTags;
+		tagsOfType(frees0, rhs(0), TensorStanza::INDEX_TYPE_FREE);
+		tagsOfType(frees1, rhs(1), TensorStanza::INDEX_TYPE_FREE);
+		tagsOfType(summedTags, rhs(0), TensorStanza::INDEX_TYPE_SUMMED);
+
+		SizeType rows = volumeOf(frees0, dimensions);
+		SizeType cols = volumeOf(frees1, dimensions);
+		SizeType inner = volumeOf(summedTags, dimensionsSummed);
+
+		VectorSizeType place0;
+		VectorSizeType place1;
+		PlanEnum plan = planForTarget(place0, place1, frees0, frees1, dimensions);
+		if (plan == PLAN_NONE)
+			outputTensor().setSizes(dimensions);
+
+		VectorSizeType free(total, 0);
+		VectorSizeType summed(totalSummed, 0);
+		VectorSizeType partner;
+		bool conjugatePair = isConjugatePair(partner, frees0);
+
+		// an h operand found sparse before is not gathered again
+		SizeType hSide = (rhs(0).name() == "h") ? 0 : 1;
+		if (rhs(hSide).name() != "h" || conjugatePair) hSide = 2;
+		SparseOperandType localSparse;
+		const SparseOperandType* sparse = (pool_ && hSide < 2) ?
+		            pool_->sparseOperand(rhs.sRep()) : 0;
+		bool skip0 = (sparse && sparse->sparse && hSide == 0);
+		bool skip1 = (sparse && sparse->sparse && hSide == 1);
+
+		MatrixType m0((skip0) ? 0 : rows, (skip0) ? 0 : inner);
+		MatrixType m1((skip1) ? 0 : inner, (skip1) ? 0 : cols);
+		for (SizeType k = 0; k < inner; ++k) {
+			indexToTags(summed, summedTags, dimensionsSummed, k);
+			for (SizeType i = 0; i < rows && !skip0; ++i) {
+				indexToTags(free, frees0, dimensions, i);
+				m0(place0[i], k) = evalThisTensor(rhs(0), summed, free);
+			}
+
+			for (SizeType j = 0; j < cols && !skip1; ++j) {
+				indexToTags(free, frees1, dimensions, j);
+				if (conjugatePair) {
+					SizeType i = tagsToIndex(free, partner, frees0, dimensions);
+					m1(k, place1[j]) = PsimagLite::conj(m0(place0[i], k));
+					continue;
+				}
+
+				m1(k, place1[j]) = evalThisTensor(rhs(1), summed, free);
+			}
+		}
+
+		if (hSide < 2 && !sparse) {
+			SparseOperandType& s = (pool_) ? pool_->addSparseOperand(rhs.sRep())
+			                               : localSparse;
+			findSparse(s,
+			           hSide,
+			           (hSide == 0) ? m0 : m1,
+			           (hSide == 0) ? place0 : place1,
+			           (hSide == 0) ? frees0 : frees1,
+			           summedTags,
+			           dimensions,
+			           dimensionsSummed);
+			sparse = &s;
+		}
+
+		if (sparse && !sparse->sparse) sparse = 0;
+		const MatrixType& other = (hSide == 0) ? m1 : m0;
+		const VectorSizeType& hPlace = (hSide == 0) ? place0 : place1;
+
 		const ComplexOrRealType alpha = 1.0;
+		if (plan == PLAN_DIRECT || plan == PLAN_TRANSPOSED) {
+			MatrixType& m = target_->m;
+			assert(rows*cols == m.n_row()*m.n_col());
+			bool direct = (plan == PLAN_DIRECT);
+			if (sparse) {
+				multiplySparse(&(m(0,0)),
+				               (direct) ? 1 : cols,
+				               (direct) ? rows : 1,
+				               other,
+				               *sparse,
+				               dataOf(rhs(hSide)),
+				               hPlace,
+				               hSide);
+				target_->done = true;
+				return handle;
+			}
+
+			psimag::BLAS::GEMM((direct) ? 'N' : 'T',
+			                   (direct) ? 'N' : 'T',
+			                   (direct) ? rows : cols,
+			                   (direct) ? cols : rows,
+			                   inner,
+			                   alpha,
+			                   (direct) ? &(m0(0,0)) : &(m1(0,0)),
+			                   (direct) ? rows : inner,
+			                   (direct) ? &(m1(0,0)) : &(m0(0,0)),
+			                   (direct) ? inner : rows,
+			                   alpha,
+			                   &(m(0,0)),
+			                   (direct) ? rows : cols);
+			target_->done = true;
+			return handle;
+		}
+
+		MatrixType m2(rows, cols);
 		const ComplexOrRealType beta = 0.0;
-		int errorCodeNotSetFixme = 0;
-		psimag::BLAS::GEMM('N',
-		                   'N',
-		                   frees1,
-		                   frees2,
-		                   summed,
-		                   alpha,
-		                   &(m1(0,0)),
-		                   frees1,
-		                   &(m2(0,0)),
-		                   summed,
-		                   beta,
-		                   &(m3(0,0)),
-		                   errorCodeNotSetFixme);
-
-		reshapeIntoTensor(outputTensor(), m3, srepStatement_.rhs());
+		if (sparse)
+			multiplySparse(&(m2(0,0)), 1, rows, other, *sparse, dataOf(rhs(hSide)), hPlace, hSide);
+		else
+			psimag::BLAS::GEMM('N',
+			                   'N',
+			                   rows,
+			                   cols,
+			                   inner,
+			                   alpha,
+			                   &(m0(0,0)),
+			                   rows,
+			                   &(m1(0,0)),
+			                   inner,
+			                   beta,
+			                   &(m2(0,0)),
+			                   rows);
+
+		if (plan == PLAN_SCATTER) {
+			scatterIntoTarget(m2, frees0, frees1, dimensions, target_->stride);
+			if (target_->mirrorStride.size() > 0)
+				scatterIntoTarget(m2, frees0, frees1, dimensions, target_->mirrorStride);
+			target_->done = true;
+			return handle;
+		}
+
+		for (SizeType i = 0; i < rows; ++i) {
+			indexToTags(free, frees0, dimensions, i);
+			for (SizeType j = 0; j < cols; ++j) {
+				indexToTags(free, frees1, dimensions, j);
+				outputTensor()(free) = m2(i, j);
+			}
+		}
 
 		return handle;
 	}
 
-	void reshapeIntoMatrix(MatrixType& m,
-	                       const TensorStanza& ts,
+	// with a target, the product m0*m1 goes into its matrix with one GEMM
+	// if the frees of rhs(0) are the fastest legs of the matrix and those of
+	// rhs(1) the slowest (PLAN_DIRECT), or the other way around
+	// (PLAN_TRANSPOSED), in any order, because place0 and place1 put the
+	// rows of m0 and the columns of m1 where the matrix has them
+	PlanEnum planForTarget(VectorSizeType& place0,
+	                       VectorSizeType& place1,
+	                       const VectorSizeType& frees0,
+	                       const VectorSizeType& frees1,
 	                       const VectorSizeType& dimensions) const
 	{
-		SizeType totalSummed = ts.maxTag('s') + 1;
-		VectorSizeType dimensionsSummed(totalSummed, 0);
-		VectorVectorSizeType q;
-		bool hasSummed = ts.hasLegType('s');
-		if (hasSummed) {
-			prepareStanza(dimensionsSummed, q, ts, TensorStanza::INDEX_TYPE_SUMMED);
-		} else {
-			assert(dimensionsSummed.size() == 1);
-			dimensionsSummed[0] = 1;
-		}
+		SizeType rows = volumeOf(frees0, dimensions);
+		SizeType cols = volumeOf(frees1, dimensions);
+		place0.resize(rows);
+		place1.resize(cols);
+		for (SizeType i = 0; i < rows; ++i)
+			place0[i] = i;
+		for (SizeType j = 0; j < cols; ++j)
+			place1[j] = j;
 
-		VectorSizeType reducedDimensions;
-		reduceDimensions(reducedDimensions, dimensions, ts);
-		m.resize(volumeOf(reducedDimensions), volumeOf(dimensionsSummed));
-		SizeType total = reducedDimensions.size();
-		VectorSizeType free(total, 0);
+		if (!target_) return PLAN_NONE;
+		if (target_->mirrorStride.size() > 0) return PLAN_SCATTER;
 
-		do {
-			SizeType row = vectorToIndex(free, reducedDimensions);
-			reshapeIntoMatrix(m, ts, free, row, dimensionsSummed);
-		} while (ProgramGlobals::nextIndex(free,reducedDimensions,total));
+		VectorSizeType offsets0;
+		VectorSizeType offsets1;
+		offsetsOf(offsets0, frees0, dimensions, target_->stride);
+		offsetsOf(offsets1, frees1, dimensions, target_->stride);
+		if (isPlacement(place0, offsets0, 1, rows) &&
+		        isPlacement(place1, offsets1, rows, cols))
+			return PLAN_DIRECT;
+
+		if (isPlacement(place1, offsets1, 1, cols) &&
+		        isPlacement(place0, offsets0, cols, rows))
+			return PLAN_TRANSPOSED;
+
+		for (SizeType i = 0; i < rows; ++i)
+			place0[i] = i;
+		for (SizeType j = 0; j < cols; ++j)
+			place1[j] = j;
+		return PLAN_SCATTER;
 	}
 
-	void reshapeIntoMatrix(MatrixType& m,
-	                       const TensorStanza& ts1,
-	                       const VectorSizeType& free,
-	                       SizeType row,
-	                       const VectorSizeType& dimensions) const
+	// true if offsets are unit times a permutation of 0, ..., n - 1,
+	// which then goes into place
+	static bool isPlacement(VectorSizeType& place,
+	                        const VectorSizeType& offsets,
+	                        SizeType unit,
+	                        SizeType n)
 	{
-		TensorStanza ts = ts1;
-		ts.canonicalize();
-		SizeType total = ts.maxTag('s') + 1;
-		VectorSizeType summed(total, 0);
+		if (offsets.size() != n) return false;
+		PsimagLite::Vector<bool>::Type seen(n, false);
+		for (SizeType i = 0; i < n; ++i) {
+			div_t x = div(offsets[i], unit);
+			if (x.rem != 0 || static_cast<SizeType>(x.quot) >= n || seen[x.quot])
+				return false;
+			seen[x.quot] = true;
+			place[i] = x.quot;
+		}
 
-		do {
-			SizeType col = vectorToIndex(summed, dimensions);
-			m(row, col) = evalThisTensor(ts, summed, free);
-		} while (ProgramGlobals::nextIndex(summed,dimensions,total));
+		return true;
 	}
 
-	void reshapeIntoTensor(TensorType& tensor,
-	                       const MatrixType& src,
-	                       const TensorSrep& srep) const
-	{
-		SizeType rows = src.rows();
-		SizeType cols = src.cols();
-		SizeType total1 = srep(0).maxTag('f') + 1;
-		SizeType total2 = srep(1).maxTag('f') + 1;
-		VectorVectorSizeType q;
-		VectorSizeType dimensions1;
-		prepareStanza(dimensions1,q,srep(0),TensorStanza::INDEX_TYPE_FREE);
-		VectorSizeType dimensions2;
-		prepareStanza(dimensions2,q,srep(1),TensorStanza::INDEX_TYPE_FREE);
-		MatrixType frees1(rows, total1);
-		MatrixType frees2(cols, total2);
-		for (SizeType i = 0; i < rows; ++i)
-			getFrees(frees1, i, dimensions1);
+	// Hamiltonian terms are mostly zero for larger local dimensions,
+	// Hubbard for example; m is rhs(side), an h, gathered with its rows
+	// (side 0) or columns (side 1) put by place
+	void findSparse(SparseOperandType& sparse,
+	                SizeType side,
+	                const MatrixType& m,
+	                const VectorSizeType& place,
+	                const VectorSizeType& frees,
+	                const VectorSizeType& summedTags,
+	                const VectorSizeType& dimensions,
+	                const VectorSizeType& dimensionsSummed) const
+	{
+		const TensorStanza& stanza = srepStatement_.rhs()(side);
+		SizeType outers = (side == 0) ? m.n_row() : m.n_col();
+		SizeType inners = (side == 0) ? m.n_col() : m.n_row();
+		SizeType total = outers*inners;
+		SizeType nonzeros = 0;
+		const ComplexOrRealType* data = &(m(0,0));
+		for (SizeType x = 0; x < total; ++x)
+			if (data[x] != static_cast<ComplexOrRealType>(0.0)) ++nonzeros;
+
+		sparse.sparse = (nonzeros*SPARSE_FILL_INVERSE <= total);
+		if (!sparse.sparse) return;
+
+		const ComplexOrRealType* base = &(dataOf(stanza)[0]);
+		VectorSizeType free(dimensions.size(), 0);
+		VectorSizeType summed(dimensionsSummed.size(), 0);
+		for (SizeType k = 0; k < inners; ++k) {
+			indexToTags(summed, summedTags, dimensionsSummed, k);
+			for (SizeType o = 0; o < outers; ++o) {
+				const ComplexOrRealType& value = (side == 0) ? m(place[o], k)
+				                                             : m(k, place[o]);
+				if (value == static_cast<ComplexOrRealType>(0.0)) continue;
+				indexToTags(free, frees, dimensions, o);
+				sparse.outer.push_back(o);
+				sparse.inner.push_back(k);
+				sparse.index.push_back(&evalThisTensor(stanza, summed, free) - base);
+			}
+		}
+	}
 
-		for (SizeType j = 0; j < cols; ++j)
-			getFrees(frees2, j, dimensions2);
+	const typename TensorType::VectorComplexOrRealType& dataOf(const TensorStanza& stanza) const
+	{
+		return tensorOf(PairStringSizeType(stanza.name(), stanza.id()))->data();
+	}
 
-		VectorSizeType frees(total1 + total2, 0);
+	// c(i,j), at c[i*rowStride + j*colStride], += sum_k m0(i,k)*m1(k,j),
+	// where m0 (side 0) or m1 (side 1) is an h, given by its nonzeros and
+	// its data h, and other is the matrix on the other side
+	static void multiplySparse(ComplexOrRealType* c,
+	                           SizeType rowStride,
+	                           SizeType colStride,
+	                           const MatrixType& other,
+	                           const SparseOperandType& sparse,
+	                           const typename TensorType::VectorComplexOrRealType& h,
+	                           const VectorSizeType& place,
+	                           SizeType side)
+	{
+		SizeType nonzeros = sparse.index.size();
+		if (side == 0) {
+			SizeType cols = other.n_col();
+			VectorSizeType rowOf(nonzeros, 0);
+			typename TensorType::VectorComplexOrRealType values(nonzeros, 0.0);
+			for (SizeType x = 0; x < nonzeros; ++x) {
+				rowOf[x] = place[sparse.outer[x]]*rowStride;
+				values[x] = h[sparse.index[x]];
+			}
 
-		for (SizeType i = 0; i < rows; ++i) {
 			for (SizeType j = 0; j < cols; ++j) {
-				combineFrees(frees, frees1, frees2, i, j);
-				// update output tensor
-				err("need code to update output tensor\n");
+				ComplexOrRealType* cj = c + j*colStride;
+				const ComplexOrRealType* m1j = &(other(0,j));
+				for (SizeType x = 0; x < nonzeros; ++x)
+					cj[rowOf[x]] += values[x]*m1j[sparse.inner[x]];
 			}
+
+			return;
 		}
+
+		SizeType rows = other.n_row();
+		for (SizeType x = 0; x < nonzeros; ++x) {
+			ComplexOrRealType* cj = c + place[sparse.outer[x]]*colStride;
+			ComplexOrRealType value = h[sparse.index[x]];
+			const ComplexOrRealType* m0k = &(other(0, sparse.inner[x]));
+			for (SizeType i = 0; i < rows; ++i)
+				cj[i*rowStride] += m0k[i]*value;
+		}
+	}
+
+	void scatterIntoTarget(const MatrixType& m2,
+	                       const VectorSizeType& frees0,
+	                       const VectorSizeType& frees1,
+	                       const VectorSizeType& dimensions,
+	                       const VectorSizeType& stride) const
+	{
+		VectorSizeType offsets0;
+		VectorSizeType offsets1;
+		offsetsOf(offsets0, frees0, dimensions, stride);
+		offsetsOf(offsets1, frees1, dimensions, stride);
+		ComplexOrRealType* m = &(target_->m(0,0));
+		for (SizeType j = 0; j < offsets1.size(); ++j)
+			for (SizeType i = 0; i < offsets0.size(); ++i)
+				m[offsets0[i] + offsets1[j]] += m2(i, j);
 	}
 
-	SizeType volumeOf(const VectorSizeType& v) const
+	// offset in the target of each index of tags
+	void offsetsOf(VectorSizeType& offsets,
+	               const VectorSizeType& tags,
+	               const VectorSizeType& d,
+	               const VectorSizeType& stride) const
 	{
-		SizeType n = v.size();
-		if (n == 0) return 1;
-		SizeType prod = v[0];
-		for (SizeType i = 1; i < n; ++i) {
-			prod *= v[i];
+		SizeType volume = volumeOf(tags, d);
+		offsets.assign(volume, 0);
+		for (SizeType index = 0; index < volume; ++index) {
+			SizeType x = index;
+			for (SizeType i = 0; i < tags.size(); ++i) {
+				SizeType tag = tags[i];
+				assert(tag < stride.size());
+				div_t y = div(x, d[tag]);
+				offsets[index] += y.rem*stride[tag];
+				x = y.quot;
+			}
 		}
+	}
 
-		return prod;
+	// if rhs is a temporary with all legs free, not conjugated, a new target
+	// for the temporary, with the strides of target_ moved to its legs
+	MatrixTarget* targetOfAlias(PairStringSizeType& nameId,
+	                            const PsimagLite::String& rhs) const
+	{
+		TensorSrepType tsrep(rhs);
+		if (tsrep.size() != 1) return 0;
+		const TensorStanza& stanza = tsrep(0);
+		if (stanza.name() != "t" || stanza.isConjugate()) return 0;
+
+		SizeType legs = stanza.legs();
+		for (SizeType j = 0; j < legs; ++j) {
+			if (stanza.legType(j) != TensorStanza::INDEX_TYPE_FREE) return 0;
+			if (stanza.legTag(j) >= target_->stride.size()) return 0;
+		}
+
+		bool mirror = (target_->mirrorStride.size() > 0);
+		MatrixTarget* target = new MatrixTarget(target_->m);
+		target->stride.resize(legs, 0);
+		if (mirror)
+			target->mirrorStride.resize(legs, 0);
+
+		for (SizeType j = 0; j < legs; ++j) {
+			SizeType tag = stanza.legTag(j);
+			target->stride[j] = target_->stride[tag];
+			if (mirror)
+				target->mirrorStride[j] = target_->mirrorStride[tag];
+		}
+
+		nameId = PairStringSizeType(stanza.name(), stanza.id());
+		return target;
 	}
 
-	void reduceDimensions(VectorSizeType& rd,
-	                      const VectorSizeType& v,
-	                      const TensorStanza& ts) const
+	// rhs(1) is rhs(0) conjugated with the same summed legs, so the second
+	// factor is the first one conjugated and transposed; partner[i] is the
+	// free of rhs(1) on the leg that has free frees0[i] in rhs(0)
+	bool isConjugatePair(VectorSizeType& partner, const VectorSizeType& frees0) const
 	{
-		SizeType n = v.size();
-		if (n == 0) return;
-		PsimagLite::Vector<bool>::Type free(n, false);
-		SizeType legs = ts.legs();
-		SizeType count = 0;
-		for (SizeType i = 0; i < legs; ++i) {
-			if (ts.legType(i) != TensorStanza::INDEX_TYPE_FREE)
+		const TensorStanza& a = srepStatement_.rhs()(0);
+		const TensorStanza& b = srepStatement_.rhs()(1);
+		if (a.name() != b.name() || a.id() != b.id()) return false;
+		if (a.isConjugate() == b.isConjugate() || a.legs() != b.legs()) return false;
+
+		partner.resize(frees0.size(), 0);
+		SizeType legs = a.legs();
+		for (SizeType j = 0; j < legs; ++j) {
+			if (a.legType(j) != b.legType(j)) return false;
+			if (a.legType(j) == TensorStanza::INDEX_TYPE_SUMMED) {
+				if (a.legTag(j) != b.legTag(j)) return false;
 				continue;
-			free[ts.legTag(i)] = true;
-			++count;
+			}
+
+			if (a.legType(j) != TensorStanza::INDEX_TYPE_FREE) continue;
+			typename VectorSizeType::const_iterator it = std::find(frees0.begin(),
+			                                              frees0.end(),
+			                                              a.legTag(j));
+			assert(it != frees0.end());
+			partner[it - frees0.begin()] = b.legTag(j);
 		}
 
-		rd.resize(count);
-		SizeType j = 0;
-		for (SizeType i = 0; i < n; ++i) {
-			if (!free[i]) continue;
-			rd[j++] = v[i];
+		return true;
+	}
+
+	// inverse of indexToTags, reading the value of tags[i] from free[partner[i]]
+	SizeType tagsToIndex(const VectorSizeType& free,
+	                     const VectorSizeType& partner,
+	                     const VectorSizeType& tags,
+	                     const VectorSizeType& d) const
+	{
+		SizeType index = 0;
+		SizeType prod = 1;
+		for (SizeType i = 0; i < tags.size(); ++i) {
+			assert(partner[i] < free.size() && tags[i] < d.size());
+			index += free[partner[i]]*prod;
+			prod *= d[tags[i]];
 		}
+
+		return index;
 	}
 
-	void getFrees(MatrixType& frees, SizeType row, const VectorSizeType& d) const
+	// the fast path needs every summed index shared by the two tensors
+	bool summedAreShared() const
 	{
-		SizeType n = d.size();
-		assert(n > 0);
-		assert(frees.rows() == n);
-		SizeType prod = d[0];
-		for (SizeType i = 1; i < n - 1; ++i) {
-			prod *= d[i-1];
+		const TensorSrepType& rhs = srepStatement_.rhs();
+		VectorSizeType summed0;
+		VectorSizeType summed1;
+		tagsOfType(summed0, rhs(0), TensorStanza::INDEX_TYPE_SUMMED);
+		tagsOfType(summed1, rhs(1), TensorStanza::INDEX_TYPE_SUMMED);
+		return (summed0 == summed1);
+	}
+
+	void tagsOfType(VectorSizeType& tags,
+	                const TensorStanza& ts,
+	                TensorStanza::IndexTypeEnum type) const
+	{
+		SizeType legs = ts.legs();
+		for (SizeType j = 0; j < legs; ++j) {
+			if (ts.legType(j) != type) continue;
+			tags.push_back(ts.legTag(j));
 		}
 
-		SizeType temp = row;
-		SizeType j = 0;
-		SizeType k = (n >= 2) ? n - 2 : 0;
-		while (j < n && k < n) {
-			div_t q = div(temp, prod);
-			frees(row, j++) = q.quot;
-			temp = q.rem;
-			prod /= d[k--];
+		std::sort(tags.begin(), tags.end());
+	}
+
+	SizeType volumeOf(const VectorSizeType& tags, const VectorSizeType& d) const
+	{
+		SizeType prod = 1;
+		for (SizeType i = 0; i < tags.size(); ++i) {
+			assert(tags[i] < d.size());
+			prod *= d[tags[i]];
 		}
 
-		frees(row, j++) = temp;
+		return prod;
 	}
 
-	void combineFrees(VectorSizeType& frees,
-	                  const MatrixType& frees1,
-	                  const MatrixType& frees2,
-	                  SizeType ind,
-	                  SizeType jnd) const
+	void indexToTags(VectorSizeType& v,
+	                 const VectorSizeType& tags,
+	                 const VectorSizeType& d,
+	                 SizeType index) const
 	{
-		SizeType total1 = frees1.cols();
-		SizeType total2 = frees2.cols();
-		assert(frees.size() == total1 + total2);
-		for (SizeType k = 0; k < total1; ++k)
-			frees[k] = frees1(ind, k);
-		for (SizeType k = 0; k < total2; ++k)
-			frees[k] = frees2(jnd, k);
+		for (SizeType i = 0; i < tags.size(); ++i) {
+			SizeType tag = tags[i];
+			assert(tag < v.size() && tag < d.size());
+			div_t x = div(index, d[tag]);
+			v[tag] = x.rem;
+			index = x.quot;
+		}
 	}
 
-	SizeType vectorToIndex(const VectorSizeType& v,
-	                       const VectorSizeType& d) const
+	// the output given to the constructor, temporaries of the breakup,
+	// then the tensors given to the constructor
+	TensorType* tensorOf(const PairStringSizeType& nameId) const
 	{
-		assert(v.size() > 0);
-		assert(v.size() == d.size());
-		SizeType sum = v[0];
-		for (SizeType i = 1; i < d.size(); ++i) {
-			sum += v[i]*d[i-1];
+		if (redirect_ && nameId == redirectNameId_)
+			return redirect_;
+
+		if (nameId.first == "t" && nameId.second < overlay_->size()) {
+			TensorType* t = (*overlay_)[nameId.second];
+			if (t) return t;
 		}
 
-		return sum;
+		typename MapPairStringSizeType::const_iterator it = nameIdsTensor_.find(nameId);
+		if (it == nameIdsTensor_.end() ||
+		        it->second >= data_.size() ||
+		        tensorNameIds_[it->second] != nameId) {
+			PsimagLite::String str("TensorEvalSlow: no tensor ");
+			throw PsimagLite::RuntimeError(str + nameId.first + ttos(nameId.second) + "\n");
+		}
+
+		return data_[it->second];
 	}
 
-	SizeType idNameToIndex(PsimagLite::String name, SizeType id) const
+	// of a dense contraction of the operands, or of a copy of the output
+	Profiler::Cost cost(bool copy) const
 	{
-		typename MapPairStringSizeType::iterator it =
-		        nameIdsTensor_.find(PairStringSizeType(name,id));
-		if (it == nameIdsTensor_.end())
-			throw PsimagLite::RuntimeError("idNameToIndex: key not found\n");
-		return it->second;
+		const TensorSrepType& rhs = srepStatement_.rhs();
+		VectorSizeType frees(srepStatement_.lhs().maxTag('f') + 1, 0);
+		VectorSizeType summed(rhs.maxTag('s') + 1, 0);
+		double operands = 0.0;
+		for (SizeType i = 0; i < rhs.size(); ++i) {
+			const TensorStanza& stanza = rhs(i);
+			if (stanza.type() == TensorStanza::TENSOR_TYPE_ERASED) continue;
+			const TensorType* t = tensorOf(PairStringSizeType(stanza.name(), stanza.id()));
+			operands += t->volume();
+			for (SizeType j = 0; j < stanza.legs() && j < t->args(); ++j) {
+				SizeType tag = stanza.legTag(j);
+				if (stanza.legType(j) == TensorStanza::INDEX_TYPE_FREE && tag < frees.size())
+					frees[tag] = t->argSize(j);
+				else if (stanza.legType(j) == TensorStanza::INDEX_TYPE_SUMMED)
+					summed[tag] = t->argSize(j);
+			}
+		}
+
+		double out = 1.0;
+		for (SizeType i = 0; i < frees.size(); ++i)
+			if (frees[i] > 0) out *= frees[i];
+		double all = out;
+		for (SizeType i = 0; i < summed.size(); ++i)
+			if (summed[i] > 0) all *= summed[i];
+
+		Profiler::Cost cost;
+		cost.calls = 1;
+		cost.flops = (copy) ? 0.0 : 2.0*all;
+		cost.bytes = sizeof(ComplexOrRealType)*((copy) ? 2.0*out : operands + out);
+		cost.peak = sizeof(ComplexOrRealType)*out;
+		return cost;
 	}
 
-	void setQnsForOutput(VectorVectorSizeType& q)
+	void setQnsForOutput(const VectorSizeType& q)
 	{
 		// remap tensor indexing into symm local indexing
-		PairStringSizeType p = tensorNameIds_[indexOfOutputTensor_];
-		PsimagLite::String str = p.first + ttos(p.second);
+		const PairStringSizeType& p = srepStatement_.nameIdOfOutput();
 
 		SizeType legs = srepStatement_.lhs().legs();
 		VectorSizeType v(legs, 0);
@@ -639,19 +1153,40 @@ private:
 
 		// set qs
 		if (symmLocal_)
-			symmLocal_->addTensor(str, q, iperm);
+			symmLocal_->addTensor(p, q, iperm);
 	}
 
 	TensorType& outputTensor()
 	{
-		assert(indexOfOutputTensor_ < data_.size());
-		return *(data_[indexOfOutputTensor_]);
+		assert(output_);
+		return *output_;
 	}
 
 	const TensorType& outputTensor() const
 	{
-		assert(indexOfOutputTensor_ < data_.size());
-		return *(data_[indexOfOutputTensor_]);
+		assert(output_);
+		return *output_;
+	}
+
+	// one statement of the breakup of parent, which owns the temporaries;
+	// with a target, the output of this statement goes there
+	TensorEvalSlow(const SrepStatementType& tSrep,
+	               const TensorEvalSlow& parent,
+	               MatrixTarget* target)
+	    : srepStatement_(tSrep),
+	      data_(parent.data_),
+	      tensorNameIds_(parent.tensorNameIds_),
+	      nameIdsTensor_(parent.nameIdsTensor_),
+	      overlay_(parent.overlay_),
+	      redirect_(parent.redirect_),
+	      redirectNameId_(parent.redirectNameId_),
+	      symmLocal_(parent.symmLocal_),
+	      modify_(false),
+	      pool_(0),
+	      output_(0),
+	      target_(target)
+	{
+		output_ = tensorOf(tSrep.nameIdOfOutput());
 	}
 
 	TensorEvalSlow(const TensorEvalSlow& other);
@@ -659,12 +1194,19 @@ private:
 	TensorEvalSlow& operator=(const TensorEvalSlow& other);
 
 	SrepStatementType srepStatement_;
-	VectorTensorType data_;
-	VectorPairStringSizeType tensorNameIds_;
-	mutable MapPairStringSizeType nameIdsTensor_;
+	const VectorTensorType& data_;
+	const VectorPairStringSizeType& tensorNameIds_;
+	const MapPairStringSizeType& nameIdsTensor_;
+	VectorTensorType temporaries_; // by id
+	const VectorTensorType* overlay_;
+	TensorType* redirect_;
+	PairStringSizeType redirectNameId_;
 	SymmetryLocalType* symmLocal_;
+	VectorPairSizeType symmTensors_; // rhs position and symmetry index
 	bool modify_;
-	SizeType indexOfOutputTensor_;
+	TensorPoolType* pool_;
+	TensorType* output_;
+	MatrixTarget* target_;
 	VectorTensorType garbage_;
 };
 }
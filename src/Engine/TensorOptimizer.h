@@ -31,6 +31,8 @@ along with MERA++. If not, see <http://www.gnu.org/licenses/>.
 #include "ParallelEnvironHelper.h"
 #include "Parallelizer.h"
 #include "ParametersForMera.h"
+#include "PolarDecomposition.h"
+#include "Profiler.h"
 
 namespace Mera {
 
@@ -40,10 +42,11 @@ class TensorOptimizer {
 	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
 	typedef PsimagLite::Vector<TensorStanza::IndexDirectionEnum>::Type VectorDirType;
 	typedef PsimagLite::Vector<bool>::Type VectorBoolType;
-	typedef ParallelEnvironHelper<ComplexOrRealType> ParallelEnvironHelperType;
+	typedef PolarDecomposition<ComplexOrRealType> PolarDecompositionType;
 
 public:
 
+	typedef ParallelEnvironHelper<ComplexOrRealType> ParallelEnvironHelperType;
 	typedef ParametersForMera<ComplexOrRealType> ParametersForMeraType;
 	typedef TensorEvalBase<ComplexOrRealType> TensorEvalBaseType;
 	typedef TensorEvalSlow<ComplexOrRealType> TensorEvalSlowType;
@@ -64,7 +67,9 @@ public:
 	typedef PsimagLite::LanczosSolver<ParametersForSolverType,SparseMatrixType,VectorType>
 	LanczosSolverType;
 	typedef typename TensorEvalSlowType::SymmetryLocalType SymmetryLocalType;
-	typedef typename PsimagLite::Stack<VectorType>::Type StackVectorType;
+	typedef typename TensorEvalSlowType::TensorPoolType TensorPoolType;
+	typedef std::pair<VectorSizeType, VectorSizeType> PairVectorSizeType;
+	typedef typename PsimagLite::Vector<PairVectorSizeType>::Type VectorPairVectorSizeType;
 
 	TensorOptimizer(IoInType& io,
 	                PsimagLite::String nameToOptimize,
@@ -86,7 +91,11 @@ public:
 	      params_(params),
 	      paramsForMera_(paramsForMera),
 	      symmLocal_(symmLocal),
-	      verbose_(false)
+	      verbose_(false),
+	      rootEnergy_(0.0),
+	      polar_(paramsForMera.polarMethod),
+	      hasSaved_(false),
+	      savePending_(false)
 	{
 		io.readline(layer_,"Layer=");
 		io.readline(firstOfLayer_,"FirstOfLayer=");
@@ -100,6 +109,17 @@ public:
 			verbose_ = (tmp > 0);
 		} catch (std::exception&) {}
 
+		if (paramsForMera_.options.find("Reflection") != PsimagLite::String::npos) {
+			PsimagLite::String flags;
+			io.readline(flags,"MirrorTerms=");
+			PsimagLite::Vector<PsimagLite::String>::Type tokens;
+			PsimagLite::split(tokens, flags, ",");
+			for (SizeType i = 0; i < tokens.size(); ++i)
+				mirrorTerms_.push_back(atoi(tokens[i].c_str()));
+			if (mirrorTerms_.size() != terms)
+				throw PsimagLite::RuntimeError("TensorOptimizer: MirrorTerms != Terms\n");
+		}
+
 		tensorSrep_.resize(terms,0);
 
 		PsimagLite::String findStr = "Environ=";
@@ -110,19 +130,21 @@ public:
 			if (index != PsimagLite::String::npos)
 				srep.replace(index,5,"=");
 			tensorSrep_[i] = new SrepStatementType(srep);
+			if (!freesByLeg(tensorSrep_[i]->lhs())) {
+				PsimagLite::String str("TensorOptimizer: frees of " + srep);
+				str += " are not numbered by leg; regenerate the input with merapp\n";
+				throw PsimagLite::RuntimeError(str);
+			}
 		}
 
-		bool flag = false;
+		// scale-invariant MERAs have no root
+		indexOfRootTensor_ = tensorNameIds_.size();
 		for (SizeType i = 0; i < tensorNameIds_.size(); ++i) {
 			if (tensorNameIds_[i].first == "r") {
 				indexOfRootTensor_ = i;
-				flag = true;
 				break;
 			}
 		}
-
-		if (!flag)
-			throw PsimagLite::RuntimeError("TensorOptimizer: Root tensor not found\n");
 	}
 
 	~TensorOptimizer()
@@ -191,6 +213,14 @@ public:
 
 	const PairStringSizeType& nameId() const { return tensorToOptimize_; }
 
+	// what update() does, for the Profiler
+	PsimagLite::String updatePhase() const
+	{
+		if (tensorToOptimize_.first != "r") return paramsForMera_.polarMethod;
+		bool fullDiag = (params_.options.find("fulldiag") != PsimagLite::String::npos);
+		return (fullDiag) ? "diag" : "lanczos";
+	}
+
 	SizeType layer() const { return layer_; }
 
 	static TensorEvalBaseType* getTensorEvalPtr(PsimagLite::String evaluator,
@@ -198,37 +228,264 @@ public:
 	                                            VectorTensorType& tensors,
 	                                            const VectorPairStringSizeType& tensorNameIds,
 	                                            MapPairStringSizeType& nameIdsTensor,
-	                                            SymmetryLocalType* symmLocal)
+	                                            SymmetryLocalType* symmLocal,
+	                                            TensorPoolType* pool = 0,
+	                                            TensorType* output = 0)
 	{
 		return ParallelEnvironHelperType::getTensorEvalPtr(evaluator,
 		                                                   srep,
 		                                                   tensors,
 		                                                   tensorNameIds,
 		                                                   nameIdsTensor,
-		                                                   symmLocal);
+		                                                   symmLocal,
+		                                                   pool,
+		                                                   output);
+	}
+
+	// r^H Y r after the root was optimized, the energy of the network if Y
+	// is its environment; for FullEnergy to check Y
+	bool energyFromEnvironment(RealType& e) const
+	{
+		if (tensorToOptimize_.first != "r" || ignore_ < tensorSrep_.size())
+			return false;
+		e = rootEnergy_;
+		return true;
+	}
+
+	// the caller runs its tasks and syncs it, then passes its matrix to update()
+	ParallelEnvironHelperType* environHelper(PsimagLite::String evaluator)
+	{
+		ParallelEnvironHelperType* helper = new ParallelEnvironHelperType(tensorSrep_,
+		                                                                  evaluator,
+		                                                                  ignore_,
+		                                                                  tensorNameIds_,
+		                                                                  nameIdsTensor_,
+		                                                                  tensors_,
+		                                                                  symmLocal_);
+		if (mirrorTerms_.size() > 0) {
+			SizeType ins = tensors_[indToOptimize_]->ins();
+			SizeType outs = tensors_[indToOptimize_]->args() - ins;
+			helper->setMirrorTerms(mirrorTerms_, outs);
+		}
+
+		return helper;
+	}
+
+	// new tensor from its environment m, which is overwritten
+	RealType update(SizeType iter, MatrixType& m)
+	{
+		MatrixType mSrc = m;
+		VectorRealType s(m.n_row(),0);
+		if (tensorToOptimize_.first == "r") { // diagonalize
+			std::cout<<"MATRIX_MAY_FOLLOW\n";
+			if (!isHermitian(m,true)) {
+				if (m.n_row() < 512) std::cout<<m;
+				throw PsimagLite::RuntimeError("Not Hermitian H\n");
+			}
+
+			bool printmatrix = (params_.options.find("printmatrix") != PsimagLite::String::npos);
+			if (params_.options.find("printMatrix") != PsimagLite::String::npos)
+				printmatrix = true;
+			if (printmatrix)
+				if (m.n_row() < 512) std::cout<<m;
+
+			SizeType args = tensors_[indToOptimize_]->args();
+			// any split of the legs folds the vector the same way
+			if (args < 2)
+				throw PsimagLite::RuntimeError("r tensor should have at least two legs\n");
+			SizeType argsOver2 = args/2;
+			SizeType rows = tensors_[indToOptimize_]->argSize(0);
+			for (SizeType i = 1; i < argsOver2; ++i)
+				rows *= tensors_[indToOptimize_]->argSize(i);
+
+			SizeType cols = tensors_[indToOptimize_]->argSize(argsOver2);
+			for (SizeType i = argsOver2 + 1; i < args; ++i)
+				cols *= tensors_[indToOptimize_]->argSize(i);
+
+			assert(rows*cols == m.n_row());
+			MatrixType t(rows,cols);
+			bool fullDiag = (params_.options.find("fulldiag") != PsimagLite::String::npos);
+			if (fullDiag) {
+				diag(m,s,'V');
+				topTensorFoldVector(t,m);
+			} else {
+				lanczosDiag(t,s,m);
+			}
+
+			writeTensor(t);
+			assert(0 < s.size());
+
+			rootEnergy_ = computeRyR(mSrc);
+			if (verbose_) std::cerr<<"r*Y(r)r="<<rootEnergy_<<"\n";
+
+			bool stopEarly = (params_.options.find("stopEarly") != PsimagLite::String::npos);
+			if (params_.options.find("stopearly") != PsimagLite::String::npos)
+				stopEarly = true;
+			if (stopEarly)
+				throw PsimagLite::RuntimeError("stopEarly requested by user\n");
+
+			return s[0];
+		}
+
+		VectorPairVectorSizeType sectors;
+		if (symmLocal_) chargeSectors(sectors);
+
+		RealType tmp = PsimagLite::norm2(m);
+		if (verbose_)
+			std::cerr<<"About to do svd matrix with norm2= "<<tmp<<"\n";
+		if (paramsForMera_.polarMethod != "svd") {
+			if (sectors.size() > 0) conserveCharges(m, sectors);
+			return polarUpdate(iter, m);
+		}
+
+		if (sectors.size() > 0)
+			return sectorUpdate(iter, m, sectors);
+
+		MatrixType vt;
+		svd('S',m,s,vt);
+		page14StepL3(m,vt);
+		RealType result = 0.0;
+		for (SizeType i = 0; i < s.size(); ++i)
+			result += s[i];
+		std::cerr<<"ITER="<<iter<<" TensorOptimizer[";
+		std::cerr<<indToOptimize_<<"] svdSumOfS= "<<result<<"\n";
+		return result;
+	}
+
+	// copies nothing: the next update writes into the spare buffer, which
+	// then swaps with the data of the tensor
+	void saveTensor()
+	{
+		hasSaved_ = true;
+		savePending_ = true;
 	}
 
 	void restoreTensor()
 	{
-		if (stack_.size() == 0)
-			throw PsimagLite::RuntimeError("restoreTensor: stack is empty\n");
-		tensors_[indToOptimize_]->data() = stack_.top();
-		stack_.pop();
+		if (!hasSaved_)
+			throw PsimagLite::RuntimeError("restoreTensor: nothing saved\n");
+		hasSaved_ = false;
+		if (savePending_) {
+			savePending_ = false;
+			return;
+		}
+
+		tensors_[indToOptimize_]->data().swap(saved_);
 	}
 
 	const SizeType& firstOfLayer() const { return firstOfLayer_; }
 
+	// takes over the terms of a translate of this tensor, so that the
+	// environment is the one of the whole layer
+	void moveEnvironmentsFrom(TensorOptimizer& other)
+	{
+		SizeType terms = tensorSrep_.size();
+		SizeType otherTerms = other.tensorSrep_.size();
+		for (SizeType i = 0; i < otherTerms; ++i) {
+			if (i == other.ignore_) {
+				delete other.tensorSrep_[i];
+			} else {
+				tensorSrep_.push_back(other.tensorSrep_[i]);
+				if (other.mirrorTerms_.size() > 0)
+					mirrorTerms_.push_back(other.mirrorTerms_[i]);
+			}
+
+			other.tensorSrep_[i] = 0;
+		}
+
+		other.tensorSrep_.clear();
+		other.mirrorTerms_.clear();
+		if (ignore_ >= terms)
+			ignore_ = tensorSrep_.size();
+	}
+
 	void copyFirstOfLayer(PsimagLite::String name, SizeType id)
 	{
 		SizeType ind = nameIdsTensor_[PairStringSizeType(name, id)];
 		tensors_[indToOptimize_]->data() = tensors_[ind]->data();
 	}
 
+	// tensors were resized; saved copies no longer fit
+	void changeOfBondDimension(SymmetryLocalType* symmLocal)
+	{
+		symmLocal_ = symmLocal;
+		hasSaved_ = false;
+		savePending_ = false;
+	}
+
+	// i tensors stand for legs of the root, so they follow its dimensions
+	void resizeIrreducibleIdentities()
+	{
+		if (tensorToOptimize_.first != "r") return;
+
+		const TensorType& r = *tensors_[indToOptimize_];
+		SizeType terms = tensorSrep_.size();
+		for (SizeType i = 0; i < terms; ++i) {
+			const TensorStanza& lhs = tensorSrep_[i]->lhs();
+			const TensorSrep& rhs = tensorSrep_[i]->rhs();
+			for (SizeType j = 0; j < rhs.size(); ++j) {
+				if (rhs(j).name() != "i") continue;
+
+				SizeType ins = rhs(j).ins();
+				VectorSizeType dimensions(2*ins, 1);
+				for (SizeType k = 0; k < ins; ++k) {
+					if (rhs(j).legType(k) != TensorStanza::INDEX_TYPE_FREE)
+						continue;
+					SizeType leg = findInOfLhs(lhs, rhs(j).legTag(k));
+					assert(leg < r.args());
+					dimensions[k] = dimensions[k + ins] = r.argSize(leg);
+				}
+
+				SizeType ind = nameIdsTensor_[PairStringSizeType("i", rhs(j).id())];
+				assert(ind < tensors_.size());
+				tensors_[ind]->setSizes(dimensions);
+				tensors_[ind]->setToConstant(0.0);
+				tensors_[ind]->setToIdentity(1.0);
+			}
+		}
+	}
+
 private:
 
-	void saveTensor()
+	/* merapp numbers the frees of an environment as the outs of the erased
+	 * tensor followed by its ins, so that tag k is the same leg in every
+	 * term, and one side of the lhs holds tags 0 to its size - 1. Inputs
+	 * from before numbered them by appearance: their terms disagree on the
+	 * legs, and the environment no longer gives the energy of the network.
+	 */
+	static bool freesByLeg(const TensorStanza& lhs)
+	{
+		SizeType legs = lhs.legs();
+		SizeType ins = lhs.ins();
+		if (legs == 0) return true;
+
+		return hasFirstTags(lhs, 0, ins) || hasFirstTags(lhs, ins, legs);
+	}
+
+	static bool hasFirstTags(const TensorStanza& lhs, SizeType start, SizeType end)
+	{
+		if (start == end) return false;
+
+		VectorBoolType seen(end - start, false);
+		for (SizeType k = start; k < end; ++k) {
+			if (lhs.legType(k) != TensorStanza::INDEX_TYPE_FREE) return false;
+			SizeType tag = lhs.legTag(k);
+			if (tag >= seen.size() || seen[tag]) return false;
+			seen[tag] = true;
+		}
+
+		return true;
+	}
+
+	SizeType findInOfLhs(const TensorStanza& lhs, SizeType tag) const
 	{
-		stack_.push(tensors_[indToOptimize_]->data());
+		SizeType ins = lhs.ins();
+		for (SizeType k = 0; k < ins; ++k) {
+			if (lhs.legType(k) != TensorStanza::INDEX_TYPE_FREE) continue;
+			if (lhs.legTag(k) == tag) return k;
+		}
+
+		throw PsimagLite::RuntimeError("findInOfLhs: " + lhs.sRep() + "\n");
 	}
 
 	PsimagLite::String conditionToSrep(PairStringSizeType nameId,
@@ -280,91 +537,170 @@ private:
 		return (args == "") ? "" : "u1000(" + args + ")= " + srep;
 	}
 
-	RealType optimizeInternal(SizeType iter, SizeType upIter, PsimagLite::String evaluator)
+	RealType optimizeInternal(SizeType iter, SizeType, PsimagLite::String evaluator)
 	{
 		if (verbose_)
 			std::cerr<<"ignore="<<ignore_<<"\n";
 		typedef PsimagLite::Parallelizer<ParallelEnvironHelperType> ParallelizerType;
 		ParallelizerType threadedEnviron(PsimagLite::Concurrency::codeSectionParams);
 
-		ParallelEnvironHelperType parallelEnvironHelper(tensorSrep_,
-		                                                evaluator,
-		                                                ignore_,
-		                                                tensorNameIds_,
-		                                                nameIdsTensor_,
-		                                                tensors_,
-		                                                symmLocal_);
-
-		threadedEnviron.loopCreate(parallelEnvironHelper);
-		parallelEnvironHelper.sync();
+		double t0 = Profiler::now();
+		ParallelEnvironHelperType* parallelEnvironHelper = environHelper(evaluator);
+		threadedEnviron.loopCreate(*parallelEnvironHelper);
+		double t1 = Profiler::now();
+		parallelEnvironHelper->sync();
+		PsimagLite::String name = tensorToOptimize_.first + ttos(tensorToOptimize_.second);
+		if (Profiler::tracing())
+			Profiler::addEvent(Profiler::mainThread(), "reduction", name, t1);
+
+		MatrixType m = parallelEnvironHelper->matrix();
+		delete parallelEnvironHelper;
+		parallelEnvironHelper = 0;
+
+		if (Profiler::enabled())
+			Profiler::addPhase(name, "environ", t0);
+
+		t0 = Profiler::now();
+		RealType e = update(iter, m);
+		if (Profiler::enabled())
+			Profiler::addPhase(name, updatePhase(), t0);
+		return e;
+	}
 
-		MatrixType m = parallelEnvironHelper.matrix();
-		MatrixType mSrc = m;
-		VectorRealType s(m.n_row(),0);
-		if (tensorToOptimize_.first == "r") { // diagonalize
-			std::cout<<"MATRIX_MAY_FOLLOW\n";
-			if (!isHermitian(m,true)) {
-				if (m.n_row() < 512) std::cout<<m;
-				throw PsimagLite::RuntimeError("Not Hermitian H\n");
+	// rows (outs) and columns (ins) of the environment, charge by charge;
+	// none unless a u or w with charges is being optimized
+	void chargeSectors(VectorPairVectorSizeType& sectors) const
+	{
+		const PsimagLite::String& name = tensorToOptimize_.first;
+		if (name != "u" && name != "w") return;
+		SizeType tensorIndex = symmLocal_->tensorIndex(tensorToOptimize_);
+		if (tensorIndex >= symmLocal_->size()) return;
+
+		const TensorType& t = *tensors_[indToOptimize_];
+		SizeType ins = t.ins();
+		SizeType legs = t.args();
+		VectorSizeType dimensions(legs, 0);
+		for (SizeType j = 0; j < legs; ++j)
+			dimensions[j] = t.dimension(j);
+
+		VectorSizeType sectorOfIn;
+		VectorSizeType sectorOfOut;
+		symmLocal_->sectorsOf(sectorOfIn, sectorOfOut, tensorIndex, dimensions, ins);
+
+		// sectors[block[k]] has the states of sector k
+		SizeType none = sectorOfIn.size() + sectorOfOut.size();
+		VectorSizeType block(none, none);
+		for (SizeType y = 0; y < sectorOfOut.size(); ++y) {
+			SizeType k = sectorOfOut[y];
+			if (block[k] == none) {
+				block[k] = sectors.size();
+				sectors.push_back(PairVectorSizeType());
 			}
 
-			bool printmatrix = (params_.options.find("printmatrix") != PsimagLite::String::npos);
-			if (params_.options.find("printMatrix") != PsimagLite::String::npos)
-				printmatrix = true;
-			if (printmatrix)
-				if (m.n_row() < 512) std::cout<<m;
-
-			SizeType args = tensors_[indToOptimize_]->args();
-			if ((args & 1) || args < 2)
-				throw PsimagLite::RuntimeError("r tensor should have even lengs\n");
-			SizeType argsOver2 = args/2;
-			SizeType rows = tensors_[indToOptimize_]->argSize(0);
-			for (SizeType i = 1; i < argsOver2; ++i)
-				rows *= tensors_[indToOptimize_]->argSize(i);
-
-			SizeType cols = tensors_[indToOptimize_]->argSize(argsOver2);
-			for (SizeType i = argsOver2 + 1; i < args; ++i)
-				cols *= tensors_[indToOptimize_]->argSize(i);
+			sectors[block[k]].first.push_back(y);
+		}
 
-			assert(rows*cols == m.n_row());
-			MatrixType t(rows,cols);
-			bool fullDiag = (params_.options.find("fulldiag") != PsimagLite::String::npos);
-			if (fullDiag) {
-				diag(m,s,'V');
-				topTensorFoldVector(t,m);
-			} else {
-				lanczosDiag(t,s,m);
-			}
+		// ins of a charge that no out has get no weight
+		for (SizeType x = 0; x < sectorOfIn.size(); ++x) {
+			SizeType k = block[sectorOfIn[x]];
+			if (k != none)
+				sectors[k].second.push_back(x);
+		}
+	}
 
-			tensors_[indToOptimize_]->setToMatrix(t);
-			assert(0 < s.size());
+	// the root may mix charge sectors, so m has entries between in and out
+	// states of different charges; the symmetric update drops them, or the
+	// new u or w would have entries that TensorEvalSlow then never sees
+	static void conserveCharges(MatrixType& m, const VectorPairVectorSizeType& sectors)
+	{
+		MatrixType p(m.n_row(), m.n_col());
+		p.setTo(0.0);
+		for (SizeType k = 0; k < sectors.size(); ++k) {
+			const VectorSizeType& rows = sectors[k].first;
+			const VectorSizeType& cols = sectors[k].second;
+			for (SizeType i = 0; i < rows.size(); ++i)
+				for (SizeType j = 0; j < cols.size(); ++j)
+					p(rows[i], cols[j]) = m(rows[i], cols[j]);
+		}
 
-			RealType e = computeRyR(mSrc);
-			if (verbose_) std::cerr<<"r*Y(r)r="<<e<<"\n";
+		m = p;
+	}
 
-			bool stopEarly = (params_.options.find("stopEarly") != PsimagLite::String::npos);
-			if (params_.options.find("stopearly") != PsimagLite::String::npos)
-				stopEarly = true;
-			if (stopEarly)
-				throw PsimagLite::RuntimeError("stopEarly requested by user\n");
+	// page14StepL3 sector by sector; an svd of the whole environment
+	// would fill the null space of a sector with states of any charge
+	RealType sectorUpdate(SizeType iter,
+	                      const MatrixType& m,
+	                      const VectorPairVectorSizeType& sectors)
+	{
+		MatrixType t(m.n_col(), m.n_row());
+		t.setTo(0.0);
+		RealType result = 0.0;
+		for (SizeType k = 0; k < sectors.size(); ++k) {
+			const VectorSizeType& rows = sectors[k].first;
+			const VectorSizeType& cols = sectors[k].second;
+			SizeType r = rows.size();
+			SizeType c = cols.size();
+			if (c < r)
+				throw PsimagLite::RuntimeError("sectorUpdate: more outs than ins\n");
+
+			MatrixType b(r, c);
+			for (SizeType i = 0; i < r; ++i)
+				for (SizeType j = 0; j < c; ++j)
+					b(i, j) = m(rows[i], cols[j]);
+
+			VectorRealType s(r, 0);
+			MatrixType vt;
+			svd('S', b, s, vt);
+			for (SizeType j = 0; j < c; ++j) {
+				for (SizeType i = 0; i < r; ++i) {
+					ComplexOrRealType sum = 0.0;
+					for (SizeType l = 0; l < r; ++l)
+						sum += PsimagLite::conj(vt(l, j))*PsimagLite::conj(b(i, l));
+					t(cols[j], rows[i]) = -sum;
+				}
+			}
 
-			return s[0];
+			for (SizeType i = 0; i < s.size(); ++i)
+				result += s[i];
 		}
 
-		RealType tmp = PsimagLite::norm2(m);
-		if (verbose_)
-			std::cerr<<"About to do svd matrix with norm2= "<<tmp<<"\n";
-		MatrixType vt;
-		svd('S',m,s,vt);
-		page14StepL3(m,vt);
-		RealType result = 0.0;
-		for (SizeType i = 0; i < s.size(); ++i)
-			result += s[i];
+		writeTensor(t);
 		std::cerr<<"ITER="<<iter<<" TensorOptimizer[";
 		std::cerr<<indToOptimize_<<"] svdSumOfS= "<<result<<"\n";
 		return result;
 	}
 
+	// same update as page14StepL3, -p^H with p the polar factor of the
+	// environment, with the current tensor as warm start
+	RealType polarUpdate(SizeType iter, const MatrixType& y)
+	{
+		TensorType& x = *tensors_[indToOptimize_];
+		SizeType douts = y.n_row();
+		SizeType dins = y.n_col();
+		if (douts*dins != x.volume())
+			throw PsimagLite::RuntimeError("polarUpdate: environment does not fit\n");
+
+		const VectorType& data = x.data();
+		MatrixType q(douts, dins);
+		for (SizeType i = 0; i < dins; ++i)
+			for (SizeType j = 0; j < douts; ++j)
+				q(j,i) = -PsimagLite::conj(data[i + j*dins]);
+
+		MatrixType p;
+		RealType result = polar_(p, y, &q);
+
+		MatrixType t(dins, douts);
+		for (SizeType i = 0; i < dins; ++i)
+			for (SizeType j = 0; j < douts; ++j)
+				t(i,j) = -PsimagLite::conj(p(j,i));
+		writeTensor(t);
+
+		std::cerr<<"ITER="<<iter<<" TensorOptimizer[";
+		std::cerr<<indToOptimize_<<"] polarSumOfS= "<<result;
+		std::cerr<<" iterations= "<<polar_.iterations()<<"\n";
+		return result;
+	}
+
 	void page14StepL3(const MatrixType& m,
 	                  const MatrixType& vt)
 	{
@@ -384,7 +720,25 @@ private:
 		}
 #endif
 
-		tensors_[indToOptimize_]->setToMatrix(t);
+		writeTensor(t);
+	}
+
+	// after saveTensor, the data of the tensor goes to saved_ and t is
+	// written into the buffer saved_ had; setToMatrix writes every element
+	// unless the tensor has no ins
+	void writeTensor(const MatrixType& t)
+	{
+		TensorType& x = *tensors_[indToOptimize_];
+		if (savePending_) {
+			savePending_ = false;
+			saved_.swap(x.data());
+			if (x.ins() == 0 || x.args() < x.ins())
+				x.data() = saved_;
+			else
+				x.data().resize(saved_.size());
+		}
+
+		x.setToMatrix(t);
 	}
 
 	void topTensorFoldVector(MatrixType& t,
@@ -423,30 +777,20 @@ private:
 		if (indToOptimize_ != indexOfRootTensor_)
 			throw PsimagLite::RuntimeError("Don't call computeRyR unless optimizing root\n");
 
-		RealType sum = 0.0;
-		const TensorType& r = *tensors_[indToOptimize_];
-		assert(r.args() == 2);
-		SizeType rows = r.argSize(0);
-		SizeType cols = r.argSize(1);
-		assert(rows*cols == y.n_col());
+		// rows of y run over the data of r, as in topTensorFoldVector
+		const VectorType& r = tensors_[indToOptimize_]->data();
+		SizeType n = r.size();
+		assert(n == y.n_col());
 		assert(y.n_row() == y.n_col());
-		VectorSizeType args1(2,0);
-		VectorSizeType args2(2,0);
-		for (SizeType i = 0; i < rows; ++i) {
-			args1[0] = i;
-			for (SizeType j = 0; j < cols; ++j) {
-				args1[1] = j;
-				for (SizeType k = 0; k < rows; ++k) {
-					args2[0] = k;
-					for (SizeType l = 0; l < cols; ++l) {
-						args2[1] = l;
-						sum += PsimagLite::conj(r(args1))*y(i+j*rows,k+l*rows)*r(args2);
-					}
-				}
-			}
+		ComplexOrRealType sum = 0.0;
+		for (SizeType i = 0; i < n; ++i) {
+			ComplexOrRealType tmp = 0.0;
+			for (SizeType j = 0; j < n; ++j)
+				tmp += y(i,j)*r[j];
+			sum += PsimagLite::conj(r[i])*tmp;
 		}
 
-		return sum;
+		return PsimagLite::real(sum);
 	}
 
 	TensorOptimizer(const TensorOptimizer&);
@@ -467,7 +811,12 @@ private:
 	const ParametersForMeraType& paramsForMera_;
 	SymmetryLocalType* symmLocal_;
 	bool verbose_;
-	StackVectorType stack_;
+	RealType rootEnergy_;
+	PolarDecompositionType polar_;
+	VectorSizeType mirrorTerms_;
+	VectorType saved_;
+	bool hasSaved_;
+	bool savePending_;
 }; // class TensorOptimizer
 } // namespace Mera
 #endif // TENSOROPTIMIZER_H
@@ -0,0 +1,161 @@
+/*
+Copyright (c) 2016, UT-Battelle, LLC
+
+MERA++, Version 0.
+
+This file is part of MERA++.
+MERA++ is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+MERA++ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with MERA++. If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef MERA_TENSOR_POOL_H
+#define MERA_TENSOR_POOL_H
+#include "Vector.h"
+#include "Tensor.h"
+#include <map>
+
+namespace Mera {
+
+/* Temporaries of TensorEvalSlow, one pool per thread. A temporary goes back
+ * to its pool when the evaluation ends and keeps its memory. They are handed
+ * out again in the same order, so the same statements evaluated again get
+ * the same buffers, which by then have the peak size of their plans.
+ * A pool also keeps, per statement, where the nonzeros of its h operand go,
+ * so that they are found once and not at each evaluation.
+ */
+template<typename ComplexOrRealType>
+class TensorPool {
+
+public:
+
+	typedef Tensor<ComplexOrRealType> TensorType;
+	typedef typename PsimagLite::Vector<TensorType*>::Type VectorTensorType;
+	typedef PsimagLite::Vector<SizeType>::Type VectorSizeType;
+
+	// nonzero x of an h operand is element index[x] of the data of h, and
+	// goes to row (or column) outer[x] and to inner[x] of the matrix of the
+	// contraction; sparse is false if h is too dense for this to pay
+	struct SparseOperand {
+
+		SparseOperand() : sparse(false) {}
+
+		bool sparse;
+		VectorSizeType outer;
+		VectorSizeType inner;
+		VectorSizeType index;
+	};
+
+	TensorPool() {}
+
+	~TensorPool()
+	{
+		for (SizeType i = 0; i < free_.size(); ++i) {
+			delete free_[i];
+			free_[i] = 0;
+		}
+	}
+
+	TensorType* get(SizeType ins)
+	{
+		if (free_.size() == 0) {
+			VectorSizeType args(1, 1); // bogus, setSizes comes later
+			return new TensorType(args, ins);
+		}
+
+		TensorType* t = free_.back();
+		free_.pop_back();
+		t->reset(ins);
+		return t;
+	}
+
+	// gives back temporaries in the order they were obtained
+	void release(VectorTensorType& temporaries)
+	{
+		for (SizeType i = temporaries.size(); i > 0; --i) {
+			free_.push_back(temporaries[i - 1]);
+			temporaries[i - 1] = 0;
+		}
+	}
+
+	// 0 if not found yet
+	const SparseOperand* sparseOperand(const PsimagLite::String& key) const
+	{
+		typename MapStringSparseOperandType::const_iterator it = sparse_.find(key);
+		return (it == sparse_.end()) ? 0 : &(it->second);
+	}
+
+	SparseOperand& addSparseOperand(const PsimagLite::String& key)
+	{
+		return sparse_[key];
+	}
+
+	// call outside threaded sections whenever an h changes, since which of
+	// its elements are zero might have changed too
+	static void clearSparseOperands()
+	{
+		VectorTensorPoolType& pools = holder_.pools;
+		for (SizeType i = 0; i < pools.size(); ++i)
+			pools[i]->sparse_.clear();
+	}
+
+	// call outside threaded sections, before ofThread
+	static void init(SizeType threads)
+	{
+		VectorTensorPoolType& pools = holder_.pools;
+		while (pools.size() < threads)
+			pools.push_back(new TensorPool);
+	}
+
+	static TensorPool* ofThread(SizeType threadNum)
+	{
+		VectorTensorPoolType& pools = holder_.pools;
+		return (threadNum < pools.size()) ? pools[threadNum] : 0;
+	}
+
+	// number of the thread of pool, 0 if it has none
+	static SizeType threadOf(const TensorPool* pool)
+	{
+		const VectorTensorPoolType& pools = holder_.pools;
+		for (SizeType i = 0; i < pools.size(); ++i)
+			if (pools[i] == pool) return i;
+		return 0;
+	}
+
+private:
+
+	typedef typename PsimagLite::Vector<TensorPool*>::Type VectorTensorPoolType;
+	typedef std::map<PsimagLite::String, SparseOperand> MapStringSparseOperandType;
+
+	struct Holder {
+
+		~Holder()
+		{
+			for (SizeType i = 0; i < pools.size(); ++i) {
+				delete pools[i];
+				pools[i] = 0;
+			}
+		}
+
+		VectorTensorPoolType pools;
+	};
+
+	TensorPool(const TensorPool&);
+
+	TensorPool& operator=(const TensorPool&);
+
+	static Holder holder_;
+	VectorTensorType free_;
+	MapStringSparseOperandType sparse_;
+}; // class TensorPool
+
+template<typename ComplexOrRealType>
+typename TensorPool<ComplexOrRealType>::Holder TensorPool<ComplexOrRealType>::holder_;
+} // namespace Mera
+#endif // MERA_TENSOR_POOL_H
@@ -111,8 +111,14 @@ public:
 			identityIdIncreased = addIrreducibleIdentity(irrIdentity);
 		if (identityIdIncreased) irrIdentity.increase();
 
+		// frees of the environment are the outs of the erased tensor
+		// followed by its ins, as ParallelEnvironHelper expects
+		SizeType ins = data_[index]->ins();
+		SizeType legs = data_[index]->legs();
 		VectorSizeType sErased;
 		data_[index]->eraseTensor(sErased);
+		if (sErased.size() == legs && ins < legs)
+			std::rotate(sErased.begin(), sErased.begin() + ins, sErased.end());
 		SizeType ntensors = data_.size();
 		SizeType count = maxTag('f') + 1;
 		if (mapping) mapping->resize(maxTag('s') + 1,1000);
@@ -123,7 +129,7 @@ public:
 			srep_ += data_[i]->sRep();
 		}
 
-		canonicalize();
+		canonicalize(false);
 	}
 
 	void setAsErased(SizeType index)
@@ -280,6 +286,52 @@ public:
 		return false;
 	}
 
+	// frees are renumbered by order of appearance, or, if freesByAppearance
+	// is false, keeping the order of their tags
+	void canonicalize(bool freesByAppearance = true)
+	{
+		// this function does the causal cone simplifications if possible
+		simplify();
+
+		VectorSizeType frees(maxTag('f') + 1,0);
+		SizeType ntensors = data_.size();
+		SizeType counter = 0;
+		if (!freesByAppearance) {
+			VectorSizeType present(frees.size(),0);
+			for (SizeType i = 0; i < ntensors; ++i) {
+				SizeType legs = data_[i]->legs();
+				for (SizeType j = 0; j < legs; ++j) {
+					if (data_[i]->legType(j) != TensorStanzaType::INDEX_TYPE_FREE)
+						continue;
+					present[data_[i]->legTag(j)] = 1;
+				}
+			}
+
+			for (SizeType i = 0; i < frees.size(); ++i)
+				if (present[i]) frees[i] = counter++;
+		}
+
+		for (SizeType i = 0; i < ntensors && freesByAppearance; ++i) {
+			SizeType legs = data_[i]->legs();
+			for (SizeType j = 0; j < legs; ++j) {
+				if (data_[i]->legType(j) != TensorStanzaType::INDEX_TYPE_FREE)
+					continue;
+				frees[data_[i]->legTag(j)] = counter++;
+			}
+		}
+
+		srep_ = "";
+		for (SizeType i = 0; i < ntensors; ++i) {
+			if (data_[i]->type() == TensorStanzaType::TENSOR_TYPE_ERASED)
+				continue;
+			data_[i]->setIndices(frees,'f');
+			data_[i]->refresh();
+			srep_ += data_[i]->sRep();
+		}
+
+		simplifySummed();
+	}
+
 private:
 
 	void parseIt()
@@ -401,35 +453,6 @@ private:
 		return true;
 	}
 
-	void canonicalize()
-	{
-		// this function does the causal cone simplifications if possible
-		simplify();
-
-		VectorSizeType frees(maxTag('f') + 1,0);
-		SizeType ntensors = data_.size();
-		SizeType counter = 0;
-		for (SizeType i = 0; i < ntensors; ++i) {
-			SizeType legs = data_[i]->legs();
-			for (SizeType j = 0; j < legs; ++j) {
-				if (data_[i]->legType(j) != TensorStanzaType::INDEX_TYPE_FREE)
-					continue;
-				frees[data_[i]->legTag(j)] = counter++;
-			}
-		}
-
-		srep_ = "";
-		for (SizeType i = 0; i < ntensors; ++i) {
-			if (data_[i]->type() == TensorStanzaType::TENSOR_TYPE_ERASED)
-				continue;
-			data_[i]->setIndices(frees,'f');
-			data_[i]->refresh();
-			srep_ += data_[i]->sRep();
-		}
-
-		simplifySummed();
-	}
-
 	void simplify()
 	{
 		while (simplifyOnce());
@@ -605,22 +628,27 @@ private:
 		for (SizeType i = 0; i < usummed1.size(); ++i)
 			usummed1[i] = i;
 
-		// one index summed must be common to r and r*
+		// at least one index summed must be common to r and r*
 		flag0 = 0;
-		PsimagLite::String str = "i" + ttos(identityId) + "(s";
+		PsimagLite::String ins("");
+		PsimagLite::String outs("");
+		SizeType newTag = maxTag('s') + 1;
 		for (SizeType i = 0; i < summed0.size(); ++i) {
 			for (SizeType j = 0; j < summed1.size(); ++j) {
 				if (summed0[i] == summed1[j]) {
+					PsimagLite::String sep = (flag0 == 0) ? "" : ",";
 					flag0 = 1;
 					assert(summed0[i] < usummed1.size());
-					usummed1[summed0[i]] = maxTag('s') + 1;
-					str += ttos(summed0[i]) + "|s" + ttos(usummed1[summed0[i]]);
+					usummed1[summed0[i]] = newTag++;
+					ins += sep + "s" + ttos(summed0[i]);
+					outs += sep + "s" + ttos(usummed1[summed0[i]]);
 					break;
 				}
 			}
 		}
 
-		return (flag0 == 0) ? "" : str + ")";
+		if (flag0 == 0) return "";
+		return "i" + ttos(identityId) + "(" + ins + "|" + outs + ")";
 	}
 
 	void relabelFrees(SizeType start)
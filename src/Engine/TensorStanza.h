@@ -247,15 +247,17 @@ public:
 	{
 		if (opaque_.type_ == TENSOR_TYPE_ERASED) return count;
 
+		// the free tag follows the position in erased, not the order of appearance
 		SizeType total = legs_.size();
 		for (SizeType i = 0; i < total; ++i) {
 			if (legs_[i].name() != 's') continue;
-			if (std::find(erased.begin(),erased.end(),legs_[i].numericTag()) ==
-			        erased.end()) continue;
+			SizeType s = legs_[i].numericTag();
+			VectorSizeType::const_iterator it = std::find(erased.begin(),erased.end(),s);
+			if (it == erased.end()) continue;
 			legs_[i].name() = 'f';
-			legs_[i].numericTag() = count++;
+			legs_[i].numericTag() = count + (it - erased.begin());
 			if (mapping)
-				mapping->operator[](legs_[i].numericTag()) = legs_[i].numericTag();
+				mapping->operator[](s) = legs_[i].numericTag();
 		}
 
 		opaque_.maxSummed_ = maxIndex('s');
@@ -34,11 +34,19 @@ public:
 	typedef typename ModelBaseType::MatrixType MatrixType;
 	typedef typename ModelBaseType::VectorMatrixType VectorMatrixType;
 	typedef typename ModelBaseType::VectorSizeType VectorSizeType;
+	typedef typename ModelBaseType::VectorVectorSizeType VectorVectorSizeType;
+	typedef typename ModelBaseType::VectorStringType VectorStringType;
 
 	Heisenberg(const VectorType& v)
-	    : twoSiteHam_(v.size(),0), shift_(0.0), qOne_(2, 0)
+	    : twoSiteHam_(v.size(),0), shift_(0.0), qOne_(2, VectorSizeType(1, 0))
 	{
-		qOne_[1] = 1;
+		// number of up spins
+		qOne_[1][0] = 1;
+
+		observableNames_.push_back("sz");
+		observables_.push_back(new MatrixType(2, 2));
+		observables_[0]->operator()(0,0) = -0.5;
+		observables_[0]->operator()(1,1) = 0.5;
 		SizeType h = 2;
 		SizeType h2 = h*h;
 		SizeType n = twoSiteHam_.size();
@@ -61,6 +69,11 @@ public:
 			delete twoSiteHam_[i];
 			twoSiteHam_[i] = 0;
 		}
+
+		for (SizeType i = 0; i < observables_.size(); ++i) {
+			delete observables_[i];
+			observables_[i] = 0;
+		}
 	}
 
 	const RealType& energyShift() const
@@ -75,7 +88,15 @@ public:
 		return *(twoSiteHam_[id]);
 	}
 
-	const VectorSizeType& qOne() const { return qOne_; }
+	const VectorVectorSizeType& qOne() const { return qOne_; }
+
+	const VectorStringType& observableNames() const { return observableNames_; }
+
+	const MatrixType& observable(SizeType i) const
+	{
+		assert(i < observables_.size());
+		return *(observables_[i]);
+	}
 
 private:
 
@@ -112,7 +133,9 @@ private:
 
 	VectorMatrixType twoSiteHam_;
 	RealType shift_;
-	VectorSizeType qOne_;
+	VectorVectorSizeType qOne_;
+	VectorStringType observableNames_;
+	VectorMatrixType observables_;
 };
 }
 #endif // HEISENBERG_H
@@ -34,12 +34,30 @@ public:
 	typedef typename ModelBaseType::MatrixType MatrixType;
 	typedef typename ModelBaseType::VectorMatrixType VectorMatrixType;
 	typedef typename ModelBaseType::VectorSizeType VectorSizeType;
+	typedef typename ModelBaseType::VectorVectorSizeType VectorVectorSizeType;
+	typedef typename ModelBaseType::VectorStringType VectorStringType;
 
 	Hubbard(const VectorType& v)
-	    : twoSiteHam_(v.size(),0), shift_(0.0), qOne_(4, 0)
+	    : twoSiteHam_(v.size(),0), shift_(0.0), qOne_(4, VectorSizeType(2, 0))
 	{
-		for (SizeType i = 0; i < qOne_.size(); ++i)
-			qOne_[i] = i;
+		// (N up, N down) of empty, up, down, and doubly occupied
+		for (SizeType i = 0; i < qOne_.size(); ++i) {
+			qOne_[i][0] = (i & 1);
+			qOne_[i][1] = (i >> 1);
+		}
+
+		// densities of up and down electrons, and double occupancy
+		observableNames_.push_back("nup");
+		observableNames_.push_back("ndown");
+		observableNames_.push_back("docc");
+		for (SizeType k = 0; k < observableNames_.size(); ++k)
+			observables_.push_back(new MatrixType(4, 4));
+		for (SizeType i = 0; i < qOne_.size(); ++i) {
+			observables_[0]->operator()(i,i) = qOne_[i][0];
+			observables_[1]->operator()(i,i) = qOne_[i][1];
+			observables_[2]->operator()(i,i) = qOne_[i][0]*qOne_[i][1];
+		}
+
 		SizeType h = 4;
 		SizeType h2 = h*h;
 		SizeType n = twoSiteHam_.size();
@@ -60,6 +78,11 @@ public:
 			delete twoSiteHam_[i];
 			twoSiteHam_[i] = 0;
 		}
+
+		for (SizeType i = 0; i < observables_.size(); ++i) {
+			delete observables_[i];
+			observables_[i] = 0;
+		}
 	}
 
 	const RealType& energyShift() const
@@ -74,7 +97,15 @@ public:
 		return *(twoSiteHam_[id]);
 	}
 
-	const VectorSizeType& qOne() const { return qOne_; }
+	const VectorVectorSizeType& qOne() const { return qOne_; }
+
+	const VectorStringType& observableNames() const { return observableNames_; }
+
+	const MatrixType& observable(SizeType i) const
+	{
+		assert(i < observables_.size());
+		return *(observables_[i]);
+	}
 
 private:
 
@@ -158,7 +189,9 @@ private:
 
 	VectorMatrixType twoSiteHam_;
 	RealType shift_;
-	VectorSizeType qOne_;
+	VectorVectorSizeType qOne_;
+	VectorStringType observableNames_;
+	VectorMatrixType observables_;
 };
 }
 #endif // MERA_HUBBARD_H
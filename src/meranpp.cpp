@@ -51,4 +51,5 @@ int main(int argc, char** argv)
 	Mera::MeraSolver<double> meraSolver(file);
 
 	meraSolver.optimize();
+	Mera::Profiler::write();
 }
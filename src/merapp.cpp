@@ -31,6 +31,7 @@ along with MERA++. If not, see <http://www.gnu.org/licenses/>.
 #include "Version.h"
 #include "DimensionSrep.h"
 #include "MeraBuilder.h"
+#include "ScaleInvariantEnviron.h"
 #include "SymmetryLocal.h"
 #include "ModelSelector.h"
 #include "ModelBase.h"
@@ -57,7 +58,7 @@ void main1(const Mera::MeraBuilder<ComplexOrRealType>& builder,
 
 	Mera::TensorSrep tsrep(srep);
 	SizeType maxLegs = 2.0*params.hamiltonianConnection.size();
-	Mera::SymmetryLocal symmLocal(tsrep.size(), model().qOne(), maxLegs);
+	Mera::SymmetryLocal symmLocal(tsrep.size(), model().qOne(), maxLegs, params.truncationPolicy);
 	Mera::DimensionSrep<Mera::SymmetryLocal> dimSrep(srep, symmLocal, params.m);
 	PsimagLite::String dsrep = dimSrep();
 
@@ -76,6 +77,24 @@ void main1(const Mera::MeraBuilder<ComplexOrRealType>& builder,
 	std::cout<<environ.environs();
 }
 
+template<typename ComplexOrRealType>
+void mainScaleInvariant(const Mera::ParametersForMera<ComplexOrRealType>& params,
+                        SizeType transitional)
+{
+	typedef Mera::ModelBase<ComplexOrRealType> ModelBaseType;
+	Mera::ModelSelector<ModelBaseType> model(params.model, params.hamiltonianConnection);
+	Mera::ScaleInvariantEnviron environ(model().qOne().size(), params.m, transitional);
+	std::cout<<params;
+	std::cout<<"ScaleInvariant="<<transitional<<"\n";
+	std::cout<<"IsMeraPeriodic=0\n";
+	std::cout<<"NoSymmetryLocal=1\n";
+	std::cout<<"IterMera=10\n";
+	std::cout<<"IterTensor=100\n";
+	// add output u1000 to be used by unitary condition checking
+	std::cout<<"DsrepEnvirons=u1000(D1,D1)"<<environ.dimensionSrep()<<"\n";
+	std::cout<<environ.environs();
+}
+
 int main(int argc, char **argv)
 {
 	// check for complex or real  here FIXME
@@ -85,20 +104,23 @@ int main(int argc, char **argv)
 	int opt = 0;
 	bool versionOnly = false;
 	bool buildOnly = false;
+	int transitional = -1;
 	SizeType sites = 0;
 	SizeType arity = 2;
 	SizeType dimension = 1;
 	double tolerance = 1e-4;
 	bool periodic = false;
+	bool modifiedBinary = false;
+	bool reflection = false;
 	MeraParametersType::VectorType hamTerms;
 	SizeType m = 0;
 	PsimagLite::String evaluator("slow");
 	PsimagLite::String strUsage(argv[0]);
 	PsimagLite::String model("Heisenberg");
-	strUsage += " -n sites -a arity -d dimension [-M model] [-m m] ";
-	strUsage += "| -S srep | -V\n";
+	strUsage += " -n sites -a arity -d dimension [-M model] [-m m] [-B] [-R] ";
+	strUsage += "| -I transitional -m m [-M model] | -S srep | -V\n";
 
-	while ((opt = getopt(argc, argv,"n:a:d:m:M:e:t:PbV")) != -1) {
+	while ((opt = getopt(argc, argv,"n:a:d:m:M:e:t:I:PBRbV")) != -1) {
 		switch (opt) {
 		case 'n':
 			sites = atoi(optarg);
@@ -121,9 +143,18 @@ int main(int argc, char **argv)
 		case 't':
 			tolerance = atof(optarg);
 			break;
+		case 'I':
+			transitional = atoi(optarg);
+			break;
 		case 'P':
 			periodic = true;
 			break;
+		case 'B':
+			modifiedBinary = true;
+			break;
+		case 'R':
+			reflection = true;
+			break;
 		case 'b':
 			buildOnly = true;
 			break;
@@ -141,10 +172,24 @@ int main(int argc, char **argv)
 	if (versionOnly)
 		return 0;
 
+	if (transitional >= 0) {
+		if (dimension != 1 || arity != 2 || m == 0)
+			usageMain(strUsage);
+		// one bond, the same everywhere
+		hamTerms.resize(1,1.0);
+		std::cout<<"#"<<argv[0]<<" version "<<MERA_VERSION<<"\n";
+		MeraParametersType params(hamTerms,m,evaluator,model,tolerance);
+		mainScaleInvariant(params,transitional);
+		return 0;
+	}
+
 	// sanity checks here
 	if (sites*arity*dimension == 0 || sites == 1)
 		usageMain(strUsage);
 
+	if (reflection && dimension != 1)
+		usageMain(strUsage);
+
 	assert(sites*dimension > 0);
 	hamTerms.resize(sites*dimension,1.0);
 	if (dimension == 1) {
@@ -154,7 +199,7 @@ int main(int argc, char **argv)
 	}
 
 	// here build srep
-	MeraBuilderType meraBuilder(sites,arity,dimension,periodic,hamTerms);
+	MeraBuilderType meraBuilder(sites,arity,dimension,periodic,hamTerms,modifiedBinary);
 
 	std::cout<<"Sites="<<sites<<"\n";
 
@@ -168,5 +213,6 @@ int main(int argc, char **argv)
 	std::cout<<"#"<<argv[0]<<" version "<<MERA_VERSION<<"\n";
 
 	MeraParametersType params(hamTerms,m,evaluator,model,tolerance);
+	if (reflection) params.options = "Reflection";
 	main1(meraBuilder,params);
 }
@@ -25,7 +25,7 @@ along with MERA++. If not, see <http://www.gnu.org/licenses/>.
 int main(int argc, char** argv)
 {
 	if (argc < 3) {
-		std::cerr<<"USAGE: "<<argv[0]<<" filename label\n";
+		std::cerr<<"USAGE: "<<argv[0]<<" filename label [arity]\n";
 		return 1;
 	}
 
@@ -36,7 +36,8 @@ int main(int argc, char** argv)
 	io.rewind();
 	io.readline(srep,argv[2]);
 
-	Mera::MeraToTikz<double> obj(srep,sites);
+	SizeType arity = (argc > 3) ? atoi(argv[3]) : 2;
+	Mera::MeraToTikz<double> obj(srep,sites,arity);
 	std::cout<<"%Created by "<<argv[0]<<" version "<<MERA_VERSION<<"\n";
 	std::cout<<obj;
 }